@@ -7,8 +7,21 @@
 
 #include "render.h"
 #include "tile_manager.h"
+#include "growable_buffer2.h"
 #include "map.h"
 
+/// An atom with its bonds, composited into a single tile.
+struct atom_composite
+{
+	/// Bonds drawn under the atom.
+	uint16_t bond_flags;
+
+	/// The composited tile.
+	int tile;
+};
+
+DEFINE_GROWABLE_BUFFER(struct atom_composite, atom_composite_buffer)
+
 static void load_atoms(int atom_tiles[128], int bond_tiles[16])
 {
 	const int bond_index = sprite_manager_load_from_file_2d("bonds.bin", 2, 2 * 16);
@@ -27,7 +40,75 @@ static void load_atoms(int atom_tiles[128], int bond_tiles[16])
 	#undef LoadItem
 }
 
-void draw_atom(const struct atom* atom, int x, int y)
+/// Composite a 2x2 tile over 2x2 sprites.
+///
+/// @param[in,out] dst The sprites to composite onto.
+/// @param[in] tile_id The tile to composite.
+static void composite_tile(struct sprite dst[2 * 2], int tile_id)
+{
+	const struct tile* tile = tile_manager_get_by_id(tile_id);
+	assert(tile->width == 2 && tile->height == 2);
+	for(int i = 0; i < 2 * 2; ++i)
+	{
+		const struct sprite* src = sprite_manager_get_by_id(tile->start_id + i);
+		for(int k = 0; k < k_sprite_size; ++k)
+			for(int l = 0; l < k_sprite_size; ++l)
+				dst[i].pixels[k][l] = color_composite_premultiplied(
+					dst[i].pixels[k][l], src->pixels[k][l]);
+	}
+}
+
+/// Get the tile of an atom with its bonds already composited.
+///
+/// Composites the tile on first use.
+///
+/// @param[in] atom The atom.
+/// @param[in] atom_tiles Tiles of the atoms.
+/// @param[in] bond_tiles Tiles of the bonds.
+/// @return The composited tile.
+static int get_composite(const struct atom* atom, const int atom_tiles[128],
+	const int bond_tiles[16])
+{
+	static struct atom_composite_buffer s_composites[128];
+
+	struct atom_composite_buffer* composites =
+		&s_composites[(uint8_t)atom->item_kind & 127];
+	for(int i = 0; i < composites->size; ++i)
+		if(composites->mem[i].bond_flags == atom->bond_flags)
+			return composites->mem[i].tile;
+
+	const int atom_tile = atom_tiles[(uint8_t)atom->item_kind & 127];
+	assert(atom_tile);
+
+	// Same order as drawing them one by one: bonds first, atom on top
+	struct sprite sprites[2 * 2];
+	memset(sprites, 0, sizeof(sprites));
+	for(int i = 0; i < 16; ++i)
+		if(atom->bond_flags & (1 << i))
+			composite_tile(sprites, bond_tiles[i]);
+	composite_tile(sprites, atom_tile);
+	for(int i = 0; i < 2 * 2; ++i)
+		sprite_classify(&sprites[i]);
+
+	struct atom_composite composite;
+	composite.bond_flags = atom->bond_flags;
+	composite.tile = tile_manager_add(sprite_manager_add(sprites, 2 * 2), 2, 2);
+	atom_composite_buffer_push(composites, &composite);
+	return composite.tile;
+}
+
+/// Draw an atom that moved since the previous tick.
+///
+/// The atom and its bonds are drawn as a single pre-composited tile,
+/// interpolated between its previous and current position.
+///
+/// @param[in] atom The atom to draw.
+/// @param[in] x Horizontal position.
+/// @param[in] y Vertical position.
+/// @param[in] from_x Horizontal position on the previous tick.
+/// @param[in] from_y Vertical position on the previous tick.
+void draw_atom_moving(const struct atom* atom, int x, int y,
+	int from_x, int from_y)
 {
 	static int s_atom_tiles[128];
 	static int s_bond_tiles[16];
@@ -42,13 +123,18 @@ void draw_atom(const struct atom* atom, int x, int y)
 
 	// Dont try to draw air
 	if(atom->item_kind)
-	{
-		for(int i = 0; i < 16; ++i)
-			if(atom->bond_flags & (1 << i))
-				render_tile(s_bond_tiles[i], x, y);
+		render_tile_moving(get_composite(atom, s_atom_tiles, s_bond_tiles),
+			x, y, from_x, from_y);
+}
 
-		int atom_tile = s_atom_tiles[atom->item_kind];
- 		assert(atom_tile);
-		render_tile(atom_tile, x, y);
-	}
+/// Draw an atom with its bonds.
+///
+/// The atom and its bonds are drawn as a single pre-composited tile.
+///
+/// @param[in] atom The atom to draw.
+/// @param[in] x Horizontal position.
+/// @param[in] y Vertical position.
+void draw_atom(const struct atom* atom, int x, int y)
+{
+	draw_atom_moving(atom, x, y, x, y);
 }
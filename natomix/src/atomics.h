@@ -0,0 +1,131 @@
+/// @file atomics.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Atomic operations.
+///
+/// Interlocked functions on MSVC, __atomic builtins everywhere else. VS
+/// does not support C11 atomics.
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// @addtogroup atomics
+/// @{
+
+/// Load a pointer, acquiring what was released with it.
+///
+/// @param[in] ptr The pointer to load.
+/// @return The value.
+static inline void* atomic_load_ptr(void* const volatile* ptr)
+{
+#ifdef _MSC_VER
+	void* value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+#else
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Replace a pointer if it still has the expected value.
+///
+/// @param[in,out] ptr The pointer to replace.
+/// @param[in] expected The value it must have.
+/// @param[in] desired The new value.
+/// @return True if replaced.
+static inline bool atomic_cas_ptr(void* volatile* ptr, void* expected,
+	void* desired)
+{
+#ifdef _MSC_VER
+	return _InterlockedCompareExchangePointer(ptr, desired, expected)
+		== expected;
+#else
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false,
+		__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Add to an integer.
+///
+/// @param[in,out] value The integer.
+/// @param[in] add The amount to add.
+/// @return The value before adding.
+static inline int32_t atomic_fetch_add_i32(volatile int32_t* value,
+	int32_t add)
+{
+#ifdef _MSC_VER
+	return (int32_t)_InterlockedExchangeAdd((volatile long*)value, add);
+#else
+	return __atomic_fetch_add(value, add, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/// Load an integer, acquiring what was released with it.
+///
+/// @param[in] value The integer.
+/// @return The value.
+static inline int32_t atomic_load_i32(const volatile int32_t* value)
+{
+#ifdef _MSC_VER
+	const int32_t result = *value;
+	_ReadWriteBarrier();
+	return result;
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Store an integer, releasing what was written before.
+///
+/// @param[out] value The integer.
+/// @param[in] desired The new value.
+static inline void atomic_store_i32(volatile int32_t* value, int32_t desired)
+{
+#ifdef _MSC_VER
+	_ReadWriteBarrier();
+	*value = desired;
+#else
+	__atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#endif
+}
+
+/// Load a 64 bit integer without tearing.
+///
+/// @param[in] value The integer.
+/// @return The value.
+static inline uint64_t atomic_load_u64(const volatile uint64_t* value)
+{
+#if defined(_MSC_VER) && defined(_M_IX86)
+	return (uint64_t)_InterlockedCompareExchange64(
+		(volatile long long*)value, 0, 0);
+#elif defined(_MSC_VER)
+	const uint64_t result = *value;
+	_ReadWriteBarrier();
+	return result;
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Replace a 64 bit integer if it still has the expected value.
+///
+/// @param[in,out] value The integer to replace.
+/// @param[in] expected The value it must have.
+/// @param[in] desired The new value.
+/// @return True if replaced.
+static inline bool atomic_cas_u64(volatile uint64_t* value, uint64_t expected,
+	uint64_t desired)
+{
+#ifdef _MSC_VER
+	return (uint64_t)_InterlockedCompareExchange64((volatile long long*)value,
+		(long long)desired, (long long)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, desired, false,
+		__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// @}
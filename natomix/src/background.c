@@ -32,5 +32,5 @@ void draw_background(int id)
 		load_backgrounds(s_bgs, 4);
 		initialized = true;
 	}
-	render_tile(s_bgs[id], 0, 0);
+	render_background(s_bgs[id]);
 }
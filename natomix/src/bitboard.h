@@ -0,0 +1,162 @@
+/// @file bitboard.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Occupancy bitboard of an arena.
+///
+/// Header only implementation of a 32x32 occupancy bitboard, stored both
+/// as rows and as columns, so a slide in any direction is resolved by a
+/// single bit scan of one word.
+
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// @addtogroup bitboard
+/// @{
+
+/// Direction of a slide.
+enum direction
+{
+	Direction_Left,
+	Direction_Right,
+	Direction_Up,
+	Direction_Down
+};
+
+/// Occupied cells of an arena.
+struct bitboard
+{
+	/// Bit x of rows[y] is set if cell x, y is occupied.
+	uint32_t rows[32];
+
+	/// Bit y of cols[x] is set if cell x, y is occupied.
+	uint32_t cols[32];
+};
+
+/// Index of the lowest set bit.
+///
+/// @param[in] bits The bits, must not be zero.
+/// @return Index of the lowest set bit.
+static inline int bit_scan_forward(uint32_t bits)
+{
+	assert(bits);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (int)index;
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+
+/// Index of the highest set bit.
+///
+/// @param[in] bits The bits, must not be zero.
+/// @return Index of the highest set bit.
+static inline int bit_scan_reverse(uint32_t bits)
+{
+	assert(bits);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, bits);
+	return (int)index;
+#else
+	return 31 - __builtin_clz(bits);
+#endif
+}
+
+/// Mark a cell occupied.
+///
+/// @param[in,out] board The bitboard.
+/// @param[in] x Column of the cell.
+/// @param[in] y Row of the cell.
+static inline void bitboard_set(struct bitboard* board, int x, int y)
+{
+	board->rows[y] |= 1u << x;
+	board->cols[x] |= 1u << y;
+}
+
+/// Mark a cell empty.
+///
+/// @param[in,out] board The bitboard.
+/// @param[in] x Column of the cell.
+/// @param[in] y Row of the cell.
+static inline void bitboard_clear(struct bitboard* board, int x, int y)
+{
+	board->rows[y] &= ~(1u << x);
+	board->cols[x] &= ~(1u << y);
+}
+
+/// Check if a cell is occupied.
+///
+/// @param[in] board The bitboard.
+/// @param[in] x Column of the cell.
+/// @param[in] y Row of the cell.
+/// @return True if occupied.
+static inline bool bitboard_get(const struct bitboard* board, int x, int y)
+{
+	return (board->rows[y] >> x) & 1;
+}
+
+/// Build the bitboard of an arena.
+///
+/// @param[out] board The bitboard.
+/// @param[in] arena The arena, non-zero cells are occupied.
+static inline void bitboard_from_arena(struct bitboard* board,
+	const char arena[32][32])
+{
+	memset(board, 0, sizeof(*board));
+	for (int x = 0; x < 32; ++x)
+		for (int y = 0; y < 32; ++y)
+			if (arena[x][y])
+				bitboard_set(board, x, y);
+}
+
+/// Find where something sliding from a cell stops.
+///
+/// It moves until the next cell is occupied, or until the edge of the
+/// arena if nothing is in the way. The starting cell itself is ignored.
+///
+/// @param[in] board The bitboard.
+/// @param[in] x Column of the starting cell.
+/// @param[in] y Row of the starting cell.
+/// @param[in] dir Direction of the slide.
+/// @param[out] stop_x Column of the stopping cell.
+/// @param[out] stop_y Row of the stopping cell.
+static inline void bitboard_slide(const struct bitboard* board, int x, int y,
+	enum direction dir, int* stop_x, int* stop_y)
+{
+	*stop_x = x;
+	*stop_y = y;
+
+	// Blockers before the cell are below its bit, after it above
+	const uint32_t before_x = (1u << x) - 1;
+	const uint32_t before_y = (1u << y) - 1;
+	const uint32_t after_x = ~before_x & ~(1u << x);
+	const uint32_t after_y = ~before_y & ~(1u << y);
+	uint32_t blockers;
+
+	switch (dir)
+	{
+	case Direction_Left:
+		blockers = board->rows[y] & before_x;
+		*stop_x = blockers ? bit_scan_reverse(blockers) + 1 : 0;
+		break;
+	case Direction_Right:
+		blockers = board->rows[y] & after_x;
+		*stop_x = blockers ? bit_scan_forward(blockers) - 1 : 31;
+		break;
+	case Direction_Up:
+		blockers = board->cols[x] & before_y;
+		*stop_y = blockers ? bit_scan_reverse(blockers) + 1 : 0;
+		break;
+	case Direction_Down:
+		blockers = board->cols[x] & after_y;
+		*stop_y = blockers ? bit_scan_forward(blockers) - 1 : 31;
+		break;
+	}
+}
+
+/// @}
@@ -0,0 +1,221 @@
+/// @file blend.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Alpha blending kernels and runtime CPU dispatch.
+///
+/// All kernels take premultiplied foreground pixels. The scalar kernel
+/// is the reference, the SSE2 and AVX2 kernels do the same integer math
+/// on 4 and 8 pixels at once.
+
+#include "pch.h"
+
+#include "blend.h"
+
+#if defined(_M_IX86) || defined(_M_X64) \
+	|| defined(__i386__) || defined(__x86_64__)
+#define BLEND_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BLEND_TARGET_AVX2
+#else
+#define BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/// @addtogroup blend
+/// @{
+
+blend_span_fn blend_span = &blend_span_scalar;
+
+/// Reference blend kernel.
+///
+/// Blends pixel by pixel with color_alpha_blend_premultiplied().
+///
+/// @param[in,out] dst Target pixels, the background.
+/// @param[in] src Source pixels, the premultiplied foreground.
+/// @param[in] count Count of pixels to blend.
+void blend_span_scalar(struct color* dst, const struct color* src,
+	int count)
+{
+	for (int i = 0; i < count; ++i)
+		dst[i] = color_alpha_blend_premultiplied(dst[i], src[i]);
+}
+
+#ifdef BLEND_X86
+
+/// Scales 2 background pixels unpacked to 16 bit channels.
+///
+/// @param[in] bg Background pixels.
+/// @param[in] fg Foreground pixels, only the alpha is used.
+/// @return The background scaled by the inverse foreground alpha.
+static inline __m128i scale2_sse2(__m128i bg, __m128i fg)
+{
+	// Broadcast alpha to all channels of the pixel
+	const __m128i alpha = _mm_shufflehi_epi16(
+		_mm_shufflelo_epi16(fg, _MM_SHUFFLE(3, 3, 3, 3)),
+		_MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(256), alpha);
+	return _mm_srli_epi16(_mm_mullo_epi16(bg, inv_alpha), 8);
+}
+
+/// Blends 4 pixels.
+///
+/// @param[in] bg Background pixels.
+/// @param[in] fg Premultiplied foreground pixels.
+/// @return The blended pixels.
+static inline __m128i blend4_sse2(__m128i bg, __m128i fg)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = scale2_sse2(
+		_mm_unpacklo_epi8(bg, zero), _mm_unpacklo_epi8(fg, zero));
+	const __m128i hi = scale2_sse2(
+		_mm_unpackhi_epi8(bg, zero), _mm_unpackhi_epi8(fg, zero));
+	return _mm_or_si128(_mm_add_epi8(_mm_packus_epi16(lo, hi), fg),
+		_mm_set1_epi32((int)0xFF000000));
+}
+
+/// SSE2 blend kernel.
+///
+/// @param[in,out] dst Target pixels, the background.
+/// @param[in] src Source pixels, the premultiplied foreground.
+/// @param[in] count Count of pixels to blend.
+static void blend_span_sse2(struct color* dst, const struct color* src,
+	int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i bg = _mm_loadu_si128((const __m128i*)&dst[i]);
+		const __m128i fg = _mm_loadu_si128((const __m128i*)&src[i]);
+		_mm_storeu_si128((__m128i*)&dst[i], blend4_sse2(bg, fg));
+	}
+	blend_span_scalar(&dst[i], &src[i], count - i);
+}
+
+/// AVX2 blend kernel.
+///
+/// Same as the SSE2 kernel, but does a whole sprite row at once.
+///
+/// @param[in,out] dst Target pixels, the background.
+/// @param[in] src Source pixels, the premultiplied foreground.
+/// @param[in] count Count of pixels to blend.
+BLEND_TARGET_AVX2
+static void blend_span_avx2(struct color* dst, const struct color* src,
+	int count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16(256);
+	const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i bg = _mm256_loadu_si256((const __m256i*)&dst[i]);
+		const __m256i fg = _mm256_loadu_si256((const __m256i*)&src[i]);
+
+		// Unpacking and packing both work within 128 bit lanes, so the
+		// pixel order comes out right.
+		__m256i scaled[2];
+		for (int half = 0; half < 2; ++half)
+		{
+			const __m256i bg16 = half
+				? _mm256_unpackhi_epi8(bg, zero)
+				: _mm256_unpacklo_epi8(bg, zero);
+			const __m256i fg16 = half
+				? _mm256_unpackhi_epi8(fg, zero)
+				: _mm256_unpacklo_epi8(fg, zero);
+			const __m256i alpha = _mm256_shufflehi_epi16(
+				_mm256_shufflelo_epi16(fg16, _MM_SHUFFLE(3, 3, 3, 3)),
+				_MM_SHUFFLE(3, 3, 3, 3));
+			scaled[half] = _mm256_srli_epi16(_mm256_mullo_epi16(
+				bg16, _mm256_sub_epi16(full, alpha)), 8);
+		}
+
+		const __m256i blended = _mm256_add_epi8(
+			_mm256_packus_epi16(scaled[0], scaled[1]), fg);
+		_mm256_storeu_si256((__m256i*)&dst[i],
+			_mm256_or_si256(blended, opaque));
+	}
+	blend_span_sse2(&dst[i], &src[i], count - i);
+}
+
+/// Checks whether the CPU and the OS support SSE2.
+static bool cpu_has_sse2(void)
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return !!(info[3] & (1 << 26));
+#else
+	__builtin_cpu_init();
+	return !!__builtin_cpu_supports("sse2");
+#endif
+}
+
+/// Checks whether the CPU and the OS support AVX2.
+static bool cpu_has_avx2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// OSXSAVE and AVX, then the OS saving the ymm registers
+	__cpuid(info, 1);
+	if ((info[2] & (3 << 27)) != (3 << 27))
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return !!(info[1] & (1 << 5));
+#else
+	__builtin_cpu_init();
+	return !!__builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+/// Selects the blend kernel for the current CPU.
+void blend_init(void)
+{
+	blend_span = &blend_span_scalar;
+
+#ifdef BLEND_X86
+	if (cpu_has_sse2())
+		blend_span = &blend_span_sse2;
+	if (cpu_has_avx2())
+		blend_span = &blend_span_avx2;
+#endif
+
+#ifndef NDEBUG
+	// Make sure the selected kernel matches the reference bit by bit,
+	// tails included.
+	for (int a = 0; a < 256; ++a)
+	{
+		enum { k_count = 11 };
+		struct color fg[k_count];
+		struct color bg[k_count];
+		struct color expected[k_count];
+		for (int i = 0; i < k_count; ++i)
+		{
+			fg[i] = color_rgba((uint8_t)(a * 7 + i * 31),
+				(uint8_t)(255 - i), (uint8_t)(a ^ i), (uint8_t)(a + i));
+			bg[i] = color_rgba((uint8_t)(i * 23), (uint8_t)(255 - a),
+				(uint8_t)(a * i), 255);
+		}
+		memcpy(expected, bg, sizeof(bg));
+		blend_span_scalar(expected, fg, k_count);
+		blend_span(bg, fg, k_count);
+		assert(memcmp(expected, bg, sizeof(bg)) == 0);
+	}
+#endif
+}
+
+/// @}
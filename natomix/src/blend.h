@@ -0,0 +1,31 @@
+/// @file blend.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Alpha blending kernels for spans of pixels.
+
+#pragma once
+#include "color.h"
+
+/// @addtogroup blend
+/// @{
+
+/// Blends a span of pixels onto a span of the bitmap.
+///
+/// @param[in,out] dst Target pixels, the background.
+/// @param[in] src Source pixels, the premultiplied foreground.
+/// @param[in] count Count of pixels to blend.
+typedef void(*blend_span_fn)(struct color* dst, const struct color* src,
+	int count);
+
+/// The fastest blend kernel available on this CPU.
+///
+/// Selected by blend_init(). All kernels give the exact same result as
+/// blend_span_scalar().
+extern blend_span_fn blend_span;
+
+extern void blend_span_scalar(struct color* dst, const struct color* src,
+	int count);
+
+extern void blend_init(void);
+
+/// @}
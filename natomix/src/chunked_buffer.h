@@ -0,0 +1,100 @@
+/// @file chunked_buffer.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief A buffer that grows without moving its elements.
+///
+/// Contains header only implementation of a buffer made of fixed size
+/// chunks. Growing it only allocates new chunks, so pointers to elements
+/// stay valid, and other threads may read elements they were handed
+/// while new ones are being added.
+
+#pragma once
+
+#define DEFINE_CHUNKED_BUFFER(Type, Name, ChunkSize, MaxChunks) \
+\
+/*! @addtogroup chunked_buffer */\
+/*! @{ */\
+\
+/*! A buffer that grows without moving its elements. */\
+struct Name\
+{\
+	/*! Allocated chunks, NULL after the last one.*/\
+	Type* chunks[MaxChunks];\
+\
+	/*! Index after the last element.*/\
+	/*!*/\
+	/*! Indices skipped at the end of a chunk are never used.*/\
+	int size;\
+};\
+\
+/*! Initialize a chunked buffer.*/\
+/*!*/\
+/*! @param[out] ctx Context to initialize */\
+static inline void Name ## _init(struct Name* ctx)\
+{\
+	memset(ctx->chunks, 0, sizeof(ctx->chunks));\
+	ctx->size = 0;\
+}\
+\
+/*! Get an element of the buffer.*/\
+/*!*/\
+/*! @param[in] ctx The buffer.*/\
+/*! @param[in] index Index of the element.*/\
+/*! @return Pointer to the element, stays valid until the buffer is freed.*/\
+static inline Type* Name ## _at(const struct Name* ctx, int index)\
+{\
+	assert(index >= 0);\
+	return &ctx->chunks[index / (ChunkSize)][index % (ChunkSize)];\
+}\
+\
+/*! Grow the buffer by \p plus count of consecutive elements*/\
+/*!*/\
+/*! The new elements are always in a single chunk, so they can be*/\
+/*! accessed as an array starting at the returned index. If they do not*/\
+/*! fit in the current chunk, the rest of it is skipped.*/\
+/*!*/\
+/*! @param[in,out] ctx Buffer to grow.*/\
+/*! @param[in] plus Count of elements, at most ChunkSize.*/\
+/*! @return The starting index of the newly available space.*/\
+static inline int Name ## _grow(struct Name* ctx, int plus)\
+{\
+	assert(plus > 0 && plus <= (ChunkSize));\
+	int start = ctx->size;\
+	if (start % (ChunkSize) + plus > (ChunkSize))\
+		start += (ChunkSize) - start % (ChunkSize);\
+\
+	const int chunk = (start + plus - 1) / (ChunkSize);\
+	assert(chunk < (MaxChunks));\
+	if (!ctx->chunks[chunk])\
+	{\
+		ctx->chunks[chunk] = (Type*)malloc((ChunkSize) * sizeof(Type));\
+		assert(ctx->chunks[chunk]);\
+	}\
+\
+	ctx->size = start + plus;\
+	return start;\
+}\
+\
+/*! Push a new element to the back of the buffer.*/\
+/*!*/\
+/*! @param[in,out] ctx Buffer to push the element to.*/\
+/*! @param[in] elem Element to push on to back of the buffer.*/\
+/*! @return Index of the newly added element.*/\
+static inline int Name ## _push(struct Name* ctx, const Type* elem)\
+{\
+	const int new_index = Name ## _grow(ctx, 1);\
+	*Name ## _at(ctx, new_index) = *elem;\
+	return new_index;\
+}\
+\
+/*! Free the buffer.*/\
+/*!*/\
+/*! @param[in,out] ctx Buffer to free.*/\
+static inline void Name ## _free(struct Name* ctx)\
+{\
+	for (int i = 0; i < (MaxChunks); ++i)\
+		free(ctx->chunks[i]);\
+	Name ## _init(ctx);\
+}\
+\
+/*! @} */
@@ -4,15 +4,41 @@
 /// @brief An RGBA 32 bit color.
 ///
 /// Header only implementation of a simple 32 bit RGBA color struct.
+///
+/// The order of the channels in memory is chosen at compile time, so
+/// frames are rendered in the order the platform presents them in.
+/// Alpha is always the last byte, so the blitters only care about the
+/// order when loading pixels from files.
 
 #pragma once
 
 /// @addtogroup color
 /// @{
 
-/// A 32 bit RGBA color.
+/// Store colors as BGRA instead of RGBA.
+///
+/// Windows bitmaps are BGRA, everything else defaults to RGBA.
+#ifndef COLOR_ORDER_BGRA
+#ifdef _WIN32
+#define COLOR_ORDER_BGRA 1
+#else
+#define COLOR_ORDER_BGRA 0
+#endif
+#endif
+
+/// A 32 bit color, in RGBA or BGRA order depending on COLOR_ORDER_BGRA.
 struct color
 {
+#if COLOR_ORDER_BGRA
+	/// Blue.
+	uint8_t b;
+
+	/// Green.
+	uint8_t g;
+
+	/// Red.
+	uint8_t r;
+#else
 	/// Red.
 	uint8_t r;
 
@@ -21,6 +47,7 @@ struct color
 
 	/// Blue.
 	uint8_t b;
+#endif
 
 	/// Alpha.
 	uint8_t a;
@@ -35,7 +62,7 @@ struct color
 /// @param[in] b Blue.
 /// @param[in] a Alpha.
 /// @return color struct
-inline struct color color_rgba(
+static inline struct color color_rgba(
 	uint8_t r,
 	uint8_t g,
 	uint8_t b,
@@ -57,7 +84,7 @@ inline struct color color_rgba(
 /// @param[in] g Green.
 /// @param[in] b Blue.
 /// @return color struct
-inline struct color color_rgb(
+static inline struct color color_rgb(
 	uint8_t r,
 	uint8_t g,
 	uint8_t b)
@@ -65,6 +92,19 @@ inline struct color color_rgb(
 	return color_rgba(r, g, b, 255);
 }
 
+/// Convert a color loaded from RGBA bytes to the native order.
+///
+/// @param[in] c Color with its bytes in RGBA order.
+/// @return The same color in the order of struct color.
+static inline struct color color_from_rgba_bytes(struct color c)
+{
+#if COLOR_ORDER_BGRA
+	return color_rgba(c.b, c.g, c.r, c.a);
+#else
+	return c;
+#endif
+}
+
 /// Blend a foreground on a background with alpha.
 ///
 /// Blends the foreground color onto the background color. Ignores
@@ -73,7 +113,7 @@ inline struct color color_rgb(
 /// @param[in] bg Background color.
 /// @param[in] fg Foreground color.
 /// @return The blended color.
-inline struct color color_alpha_blend(struct color bg, struct color fg)
+static inline struct color color_alpha_blend(struct color bg, struct color fg)
 {
 	struct color r;
 	const uint16_t alpha = fg.a + 1;
@@ -85,4 +125,71 @@ inline struct color color_alpha_blend(struct color bg, struct color fg)
 	return r;
 }
 
+/// Premultiply a color with its alpha.
+///
+/// Scales the channels the same way color_alpha_blend() scales the
+/// foreground, and keeps the alpha as is. Fully opaque colors are
+/// left unchanged, fully transparent ones become all zero except for
+/// the alpha.
+///
+/// @param[in] c Color to premultiply.
+/// @return The premultiplied color.
+static inline struct color color_premultiply(struct color c)
+{
+	struct color r;
+	const uint16_t alpha = c.a + 1;
+	r.r = (uint8_t)((alpha * c.r) >> 8);
+	r.g = (uint8_t)((alpha * c.g) >> 8);
+	r.b = (uint8_t)((alpha * c.b) >> 8);
+	r.a = c.a;
+	return r;
+}
+
+/// Blend a premultiplied foreground on a background.
+///
+/// Blends the foreground color onto the background color. Ignores
+/// background alpha. Needs one multiply per channel instead of the two
+/// of color_alpha_blend().
+///
+/// The result for color_premultiply(fg) is within one of
+/// color_alpha_blend(bg, fg) per channel, never above it: the two
+/// products are rounded down separately instead of their sum. Opaque
+/// and fully transparent foregrounds give the exact same result.
+///
+/// @param[in] bg Background color.
+/// @param[in] fg Premultiplied foreground color.
+/// @return The blended color.
+static inline struct color color_alpha_blend_premultiplied(struct color bg,
+	struct color fg)
+{
+	struct color r;
+	const uint16_t inv_alpha = 256 - fg.a;
+	r.r = (uint8_t)(fg.r + ((inv_alpha * bg.r) >> 8));
+	r.g = (uint8_t)(fg.g + ((inv_alpha * bg.g) >> 8));
+	r.b = (uint8_t)(fg.b + ((inv_alpha * bg.b) >> 8));
+	r.a = 0xFF;
+	return r;
+}
+
+/// Composite a premultiplied foreground over a premultiplied background.
+///
+/// Like color_alpha_blend_premultiplied(), but the background may be
+/// transparent too, so the alpha is composited as well. Used to merge
+/// layers into a single image ahead of time.
+///
+/// @param[in] bg Premultiplied background color.
+/// @param[in] fg Premultiplied foreground color.
+/// @return The premultiplied composite.
+static inline struct color color_composite_premultiplied(struct color bg,
+	struct color fg)
+{
+	struct color r;
+	const uint16_t inv_alpha = 256 - fg.a;
+	r.r = (uint8_t)(fg.r + ((inv_alpha * bg.r) >> 8));
+	r.g = (uint8_t)(fg.g + ((inv_alpha * bg.g) >> 8));
+	r.b = (uint8_t)(fg.b + ((inv_alpha * bg.b) >> 8));
+	r.a = (uint8_t)(fg.a + ((inv_alpha * bg.a) >> 8));
+	return r;
+}
+
 /// @}
\ No newline at end of file
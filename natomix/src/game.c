@@ -6,6 +6,8 @@
 #include "pch.h"
 
 #include "globals.h"
+#include "game.h"
+#include "blend.h"
 #include "sprite_manager.h"
 #include "keys.h"
 #include "tile_manager.h"
@@ -13,12 +15,12 @@
 #include "map_manager.h"
 #include "score_manager.h"
 #include "game_modules.h"
+#include "input.h"
+#include "telemetry.h"
+#include "trace.h"
 
 /// Current key states.
-enum key_state g_key_states[0x100];
-
-/// The displayed bitmap
-struct color g_bitmap[k_pixel_width * k_pixel_height];
+struct key_states g_keys;
 
 /// True until the game is running
 bool g_running = true;
@@ -32,9 +34,46 @@ struct global_state g_state =
 /// Font used for writing stuff.
 int g_font;
 
+/// Epoch of the game clock.
+static time_t s_epoch;
+
+/// Count of ticks since the game started.
+static long long s_ticks;
+
+/// Get the time of the game clock.
+///
+/// Advances with the ticks instead of the wall clock, so a recorded
+/// session played back sees the same times.
+///
+/// @return Seconds since the unix epoch.
+time_t game_time(void)
+{
+	return s_epoch + (time_t)(s_ticks / k_tickrate);
+}
+
+/// Get the epoch of the game clock.
+///
+/// @return The time the game started at, or the one set.
+time_t on_game_get_epoch(void)
+{
+	return s_epoch;
+}
+
+/// Set the epoch of the game clock.
+///
+/// Used to replay recorded sessions with the clock they had.
+///
+/// @param[in] epoch Time of the first tick.
+void on_game_set_epoch(time_t epoch)
+{
+	s_epoch = epoch;
+}
+
 /// Called on game start.
 void on_game_start(void)
 {
+	telemetry_init();
+	blend_init();
 	sprite_manager_init();
 	tile_manager_init();
 	render_init();
@@ -42,12 +81,19 @@ void on_game_start(void)
 	scoremgr_init();
 
 	g_font = sprite_manager_load_from_file("font.bin", 128);
+	s_epoch = time(NULL);
 }
 
 /// Called on game tick.
 void on_game_tick(void)
 {
-	if(g_key_states[Key_Escape] == KeyState_Pressed)
+	const long long span = trace_begin();
+	const long long tick_start = telemetry_now();
+	input_begin_tick();
+	const long long logic_start = telemetry_now();
+	telemetry_record(TelemetryStage_Input, logic_start - tick_start);
+
+	if(is_key_pressed(Key_Escape))
 		g_running = false;
 
 	render_start_frame();
@@ -57,7 +103,8 @@ void on_game_tick(void)
 	strftime((char*)time_str, 32, "%Y-%m-%d %H:%M:%S", localtime(&now));
 	render_printf(g_font, 50, 50, "Time: %s", time_str);*/
 
-	switch(g_state.stage)
+	const enum game_stage stage = g_state.stage;
+	switch(stage)
 	{
 	case GameState_Menu:
 		do_menu();
@@ -72,9 +119,53 @@ void on_game_tick(void)
 		break;
 	}
 
+	const long long logic_end = telemetry_now();
+	static const enum telemetry_stage k_logic_stages[] =
+	{
+		[GameState_Menu] = TelemetryStage_Menu,
+		[GameState_Highscores] = TelemetryStage_Highscores,
+		[GameState_Game] = TelemetryStage_Gameplay,
+	};
+	telemetry_record(k_logic_stages[stage], logic_end - logic_start);
+
+	input_end_tick();
+	++s_ticks;
+	telemetry_record(TelemetryStage_Tick, telemetry_now() - tick_start);
+	trace_end("on_game_tick", span);
+}
+
+/// Called when the platform wants a frame.
+///
+/// Hands the commands of the last tick to the render thread. May be
+/// called any number of times per tick, or skipped for some ticks.
+///
+/// @param[in] fraction Fraction of a tick elapsed since the last tick,
+///                     out of k_tick_fraction_one.
+void on_game_render(int fraction)
+{
+	render_render(fraction);
+}
+
+/// Get the newest rendered frame for presenting.
+///
+/// Must be followed by on_game_release_frame() once presented.
+///
+/// @param[in] wait Wait for every frame asked for to be rendered, and
+///                 return the newest one even if it was presented.
+/// @return Pixels of the frame, NULL if there is no new frame.
+const struct color* on_game_acquire_frame(bool wait)
+{
+	return render_acquire_frame(wait);
+}
 
-	render_render();
+/// Called when the platform is done presenting a frame.
+void on_game_release_frame(void)
+{
+	render_release_frame();
 }
 
 /// Called on game end.
-void on_game_end(void) {}
+void on_game_end(void)
+{
+	render_end();
+}
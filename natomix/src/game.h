@@ -8,24 +8,87 @@
 #include "keys.h"
 #include "color.h"
 
-extern struct color g_bitmap[k_pixel_width * k_pixel_height];
+/// State of every key, as one bit per key.
+struct key_states
+{
+	/// Keys held down.
+	uint32_t down[0x100 / 32];
+
+	/// Keys that changed state since the last tick.
+	uint32_t changed[0x100 / 32];
+
+	/// Keys that changed state since the last tick, in order of the first
+	/// change, each only once.
+	uint8_t changes[0x100];
+
+	/// Count of keys in changes.
+	int change_count;
+};
 
-// Could be atomic_int for more safety, but VS doesnt support it
-extern enum key_state g_key_states[0x100];
+extern struct key_states g_keys;
 
 extern bool g_running;
 
+/// Check a key in a key bitset.
+///
+/// @param[in] bits The bitset.
+/// @param[in] key Key to check.
+/// @return True if the bit of the key is set.
+static inline bool key_bit(const uint32_t* bits, enum key_code key)
+{
+	return (bits[(int)key >> 5] >> ((int)key & 31)) & 1;
+}
+
 /// Check if a key is held down.
 ///
 /// @param[in] key Key to check the state of.
 /// @return True if key is down, false otherwise.
-inline bool is_key_down(enum key_code key)
+static inline bool is_key_down(enum key_code key)
 {
-	return !!(g_key_states[(int)key] & KeyFlag_PushState);
+	return key_bit(g_keys.down, key);
+}
+
+/// Check if a key got pressed since the last tick.
+///
+/// @param[in] key Key to check the state of.
+/// @return True if key changed state and is down.
+static inline bool is_key_pressed(enum key_code key)
+{
+	return key_bit(g_keys.changed, key) && key_bit(g_keys.down, key);
+}
+
+/// Check if a key got released since the last tick.
+///
+/// @param[in] key Key to check the state of.
+/// @return True if key changed state and is up.
+static inline bool is_key_released(enum key_code key)
+{
+	return key_bit(g_keys.changed, key) && !key_bit(g_keys.down, key);
+}
+
+/// Get the state of a key.
+///
+/// @param[in] key Key to get the state of.
+/// @return The state, a combination of KeyFlag values.
+static inline enum key_state get_key_state(enum key_code key)
+{
+	return (enum key_state)(
+		(key_bit(g_keys.down, key) ? KeyFlag_PushState : 0)
+		| (key_bit(g_keys.changed, key) ? KeyFlag_ChangedState : 0));
 }
 
 extern void on_game_start(void);
 
+extern time_t on_game_get_epoch(void);
+
+extern void on_game_set_epoch(time_t epoch);
+
 extern void on_game_tick(void);
 
+extern void on_game_render(int fraction);
+
+extern const struct color* on_game_acquire_frame(bool wait);
+
+extern void on_game_release_frame(void);
+
 extern void on_game_end(void);
@@ -8,8 +8,13 @@
 
 extern void draw_atom(const struct atom* atom, int x, int y);
 
+extern void draw_atom_moving(const struct atom* atom, int x, int y,
+	int from_x, int from_y);
+
 extern void draw_background(int id);
 
+extern time_t game_time(void);
+
 extern void gameplay_load_map(int pack, int lvl);
 
 extern void gameplay_next_map(void);
@@ -10,14 +10,8 @@
 #include "game.h"
 #include "tile_manager.h"
 #include "render.h"
-
-enum direction
-{
-	Direction_Left,
-	Direction_Right,
-	Direction_Up,
-	Direction_Down
-};
+#include "molecule.h"
+#include "bitboard.h"
 
 /// Translate direction enum to 2d 1 or -1 s
 static inline void direction_to_xy(enum direction dir, int* x, int* y)
@@ -31,17 +25,22 @@ static inline void direction_to_xy(enum direction dir, int* x, int* y)
 	}
 }
 
-/// Floor based on another floats sign
-static inline float signfloorf(float val, float sign)
+enum
 {
-	const float multip = copysignf(1, sign);
-	return floorf(multip * val) * multip;
-}
+	/// Sub-cell units in a cell, positions of moving atoms are in these.
+	k_cell_units = 256,
+
+	/// Sub-cell units a moving atom travels per tick, 9 cells per second.
+	k_atom_speed = 9 * k_cell_units / k_tickrate
+};
 
 static struct
 {
 	const struct map* original_map;
 	struct map map;
+	struct molecule molecule;
+	struct bitboard board;
+	bool is_won;
 	int packid;
 	int level;
 	int score;
@@ -50,8 +49,12 @@ static struct
 	struct
 	{
 		char id;
-		float x;
-		float y;
+		int x;
+		int y;
+		int prev_x;
+		int prev_y;
+		int stop_x;
+		int stop_y;
 		enum direction direction;
 	} current_atom;
 
@@ -66,12 +69,15 @@ void gameplay_load_map(int pack, int lvl)
 {
 	g_state.stage = GameState_Game;
 
-	s_state.end_time = time(NULL) + 3 * 60;
+	s_state.end_time = game_time() + 3 * 60;
 	s_state.score = 10000;
 	s_state.packid = pack;
 	s_state.level = lvl;
 	s_state.original_map = mapmgr_get_pack_level(pack, lvl);
 	s_state.map = *s_state.original_map;
+	bitboard_from_arena(&s_state.board, s_state.map.arena);
+	molecule_init(&s_state.molecule, s_state.map.molecule);
+	s_state.is_won = molecule_find(&s_state.molecule, s_state.map.arena);
 }
 
 void gameplay_next_map(void)
@@ -97,37 +103,48 @@ static void process_movement(void)
 {
 	if(s_state.current_atom.id)
 	{
-		float x = s_state.current_atom.x;
-		float y = s_state.current_atom.y;
-		int move_x;
-		int move_y;
-		direction_to_xy(s_state.current_atom.direction, &move_x, &move_y);
-		s_state.current_atom.x += move_x * 0.07f;
-		s_state.current_atom.y += move_y * 0.07f;
-		int round_x = (int)signfloorf(x, (float)move_x);
-		int round_y = (int)signfloorf(y, (float)move_y);
-		int next_x = round_x + move_x;
-		int next_y = round_y + move_y;
-
-		// Make sure we are close enough
-		double diff = fabs((x - (float)round_x) + (y - (float)round_y));
-
-		// We hit something
-		if(s_state.map.arena[next_x][next_y] && diff < 0.15)
+		const int stop_x = s_state.current_atom.stop_x;
+		const int stop_y = s_state.current_atom.stop_y;
+		const int x = s_state.current_atom.x;
+		const int y = s_state.current_atom.y;
+		s_state.current_atom.prev_x = x;
+		s_state.current_atom.prev_y = y;
+
+		// The stop cell is known since launch, the slide is only visual
+		if(x != stop_x * k_cell_units || y != stop_y * k_cell_units)
+		{
+			int move_x;
+			int move_y;
+			direction_to_xy(s_state.current_atom.direction, &move_x, &move_y);
+			s_state.current_atom.x = x + move_x * k_atom_speed;
+			s_state.current_atom.y = y + move_y * k_atom_speed;
+
+			// Don't slide past the stop cell
+			if((s_state.current_atom.x - stop_x * k_cell_units) * move_x > 0)
+				s_state.current_atom.x = stop_x * k_cell_units;
+			if((s_state.current_atom.y - stop_y * k_cell_units) * move_y > 0)
+				s_state.current_atom.y = stop_y * k_cell_units;
+		}
+		else
 		{
-			s_state.map.arena[round_x][round_y] = s_state.current_atom.id;
+			s_state.map.arena[stop_x][stop_y] = s_state.current_atom.id;
+			bitboard_set(&s_state.board, stop_x, stop_y);
 			s_state.current_atom.id = 0;
-			s_state.cursor.x = round_x;
-			s_state.cursor.y = round_y;
+			s_state.cursor.x = stop_x;
+			s_state.cursor.y = stop_y;
+
+			// Only a placement covering the landed atom can be new
+			s_state.is_won = s_state.is_won || molecule_find_through(
+				&s_state.molecule, s_state.map.arena, stop_x, stop_y);
 		}
 	}
 	else
 	{
-		const bool is_left_pressed = g_key_states[Key_Left] == KeyState_Pressed;
-		const bool is_right_pressed = g_key_states[Key_Right] == KeyState_Pressed;
-		const bool is_up_pressed = g_key_states[Key_Up] == KeyState_Pressed;
-		const bool is_down_pressed = g_key_states[Key_Down] == KeyState_Pressed;
-		const bool is_space_held = g_key_states[Key_Space] & KeyFlag_PushState;
+		const bool is_left_pressed = is_key_pressed(Key_Left);
+		const bool is_right_pressed = is_key_pressed(Key_Right);
+		const bool is_up_pressed = is_key_pressed(Key_Up);
+		const bool is_down_pressed = is_key_pressed(Key_Down);
+		const bool is_space_held = is_key_down(Key_Space);
 
 		const int x = s_state.cursor.x;
 		const int y = s_state.cursor.y;
@@ -142,14 +159,21 @@ static void process_movement(void)
 			{
 				s_state.score -= 50;
 				s_state.current_atom.id = s_state.map.arena[x][y];
-				s_state.current_atom.x = (float)x;
-				s_state.current_atom.y = (float)y;
+				s_state.current_atom.x = x * k_cell_units;
+				s_state.current_atom.y = y * k_cell_units;
+				s_state.current_atom.prev_x = x * k_cell_units;
+				s_state.current_atom.prev_y = y * k_cell_units;
 				s_state.map.arena[x][y] = 0;
+				bitboard_clear(&s_state.board, x, y);
 				s_state.current_atom.direction =
 					is_left_pressed ? Direction_Left :
 					is_right_pressed ? Direction_Right :
 					is_up_pressed ? Direction_Up :
 					is_down_pressed ? Direction_Down : -1;
+				bitboard_slide(&s_state.board, x, y,
+					s_state.current_atom.direction,
+					&s_state.current_atom.stop_x,
+					&s_state.current_atom.stop_y);
 			}
 		}
 		else
@@ -182,35 +206,22 @@ static void render_mapview(int x, int y, int w, int h)
 		}
 
 	if(s_state.current_atom.id)
-		draw_atom(&s_state.map.atoms[s_state.current_atom.id],
-			(int)((s_state.current_atom.x + x - map_dpos_x) * k_sprite_size * 2),
-			(int)((s_state.current_atom.y + y - map_dpos_y) * k_sprite_size * 2));
+	{
+		const int cell = k_sprite_size * 2;
+		const int origin_x = (x - map_dpos_x) * cell;
+		const int origin_y = (y - map_dpos_y) * cell;
+		draw_atom_moving(&s_state.map.atoms[s_state.current_atom.id],
+			origin_x + s_state.current_atom.x * cell / k_cell_units,
+			origin_y + s_state.current_atom.y * cell / k_cell_units,
+			origin_x + s_state.current_atom.prev_x * cell / k_cell_units,
+			origin_y + s_state.current_atom.prev_y * cell / k_cell_units);
+	}
 	else
 		draw_cursor(
 			(x + cur_x - map_dpos_x) * k_sprite_size * 2,
 			(y + cur_y - map_dpos_y) * k_sprite_size * 2);
 }
 
-static bool check_win_conditions(void)
-{
-	for(int i = 0; i < 32; ++i)
-		for(int j = 0; j < 32; ++j)
-		{
-			bool match = true;
-			for(int k = 0; k < 16 && match; ++k)
-				for(int l = 0; l < 16 && match; ++l)
-					if(s_state.map.molecule[k][l])
-						if(i + k >= 32 || j + l >= 32
-							|| s_state.map.arena[i + k][j + l]
-								!= s_state.map.molecule[k][l])
-							match = false;
-			if(match)
-				return true;
-		}
-
-	return false;
-}
-
 void do_gameplay(void)
 {
 	draw_background(3);
@@ -219,13 +230,13 @@ void do_gameplay(void)
 	render_print(g_font, (k_pixel_width - (int)len * k_sprite_size) / 2, 16,
 		s_state.map.name);
 
-	const time_t left = s_state.end_time - time(NULL);
+	const time_t left = s_state.end_time - game_time();
 	render_printf(g_font, 16, 80, "Time left: %01d:%02d",
 		left / 60, left % 60);
 
 	render_printf(g_font, 16, 112, "Score: %05d", s_state.score);
 
-	if(check_win_conditions())
+	if(s_state.is_won)
 		highscore_level_finished(s_state.original_map, s_state.score + (int)left * 3);
 
 	process_movement();
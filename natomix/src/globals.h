@@ -27,6 +27,12 @@ enum
 	/// Game ticks per second.
 	k_tickrate = 128,
 
+	/// Frames presented per second by default, 0 for every tick.
+	k_present_rate = 60,
+
+	/// Fixed point one of the fraction of a tick elapsed when rendering.
+	k_tick_fraction_one = 256,
+
 	/// Height and width of a sprite.
 	k_sprite_size = 8,
 
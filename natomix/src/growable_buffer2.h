@@ -35,7 +35,7 @@ struct Name\
 /*!*/\
 /*! @param[out] ctx Context to initialize */\
 /*! @param[in] allocsize Size of one element*/\
-inline void Name ## _init(struct Name* ctx)\
+static inline void Name ## _init(struct Name* ctx)\
 {\
 	ctx->mem = NULL;\
 	ctx->alloc = 0;\
@@ -50,7 +50,7 @@ inline void Name ## _init(struct Name* ctx)\
 /*! @param[in,out] ctx The buffer to resize.*/\
 /*! @param[in] new_size New size.*/\
 /*! @return The starting index of the newly available space.*/\
-inline int Name ## _resize(struct Name* ctx,\
+static inline int Name ## _resize(struct Name* ctx,\
 	int new_size)\
 {\
 	assert(new_size >= ctx->size);\
@@ -84,7 +84,7 @@ inline int Name ## _resize(struct Name* ctx,\
 /*! @param[in,out] ctx Buffer to grow.*/\
 /*! @param[in] plus Count of elements to grow the buffer with.*/\
 /*! @return The starting index of the newly available space.*/\
-inline int Name ## _grow(struct Name* ctx, int plus)\
+static inline int Name ## _grow(struct Name* ctx, int plus)\
 {\
 	return Name ## _resize(ctx, ctx->size + plus);\
 }\
@@ -97,7 +97,7 @@ inline int Name ## _grow(struct Name* ctx, int plus)\
 /*! @param[in,out] ctx Buffer to push the element to.*/\
 /*! @param[in] elem Element to push on to back of the buffer.*/\
 /*! @return Index of the newly added element.*/\
-inline int Name ## _push(struct Name* ctx,\
+static inline int Name ## _push(struct Name* ctx,\
 	const Type* elem)\
 {\
 	const int new_index = Name ## _grow(ctx, 1);\
@@ -113,7 +113,7 @@ inline int Name ## _push(struct Name* ctx,\
 /*! @param[in,out] ctx Buffer to free.*/\
 /*! @param[in] destructor Function to run on each element of the*/\
 /*!                       buffer, NULL if disabled.*/\
-inline int Name ## _free(struct Name* ctx,\
+static inline void Name ## _free(struct Name* ctx,\
 	void(*destructor)(Type*))\
 {\
 	if(destructor)\
@@ -38,7 +38,7 @@ void highscore_level_finished(const struct map* map, int score)
 	{
 		memset(s_state.top10[place].name, ' ', 31);
 		s_state.top10[place].name[31] = 0;
-		s_state.top10[place].date = time(NULL);
+		s_state.top10[place].date = game_time();
 		s_state.top10[place].points = score;
 	}
 	s_state.topcount = MAX(count, place + 1);
@@ -48,10 +48,10 @@ static void input_behavior(int x, int y, int* cursor, char* text, int len)
 {
 	int cur = *cursor;
 
-	const bool is_left_pressed = g_key_states[Key_Left] == KeyState_Pressed;
-	const bool is_right_pressed = g_key_states[Key_Right] == KeyState_Pressed;
-	const bool is_up_pressed = g_key_states[Key_Up] == KeyState_Pressed;
-	const bool is_down_pressed = g_key_states[Key_Down] == KeyState_Pressed;
+	const bool is_left_pressed = is_key_pressed(Key_Left);
+	const bool is_right_pressed = is_key_pressed(Key_Right);
+	const bool is_up_pressed = is_key_pressed(Key_Up);
+	const bool is_down_pressed = is_key_pressed(Key_Down);
 
 	if(is_left_pressed) --cur;
 	if(is_right_pressed) ++cur;
@@ -91,7 +91,7 @@ void do_highscores(void)
 			input_behavior(8 + 15 * 8, 16 + i * 16, &cur, s_state.top10[i].name, 29);
 	}
 
-	if(g_key_states[Key_Return] == KeyState_Pressed)
+	if(is_key_pressed(Key_Return))
 	{
 		if(s_state.myplace < 10)
 			scoremgr_add_new_record(s_state.map, s_state.top10[s_state.myplace]);
@@ -0,0 +1,220 @@
+/// @file input.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Platform independent input, with recording and playback.
+///
+/// Platforms report key changes with input_key_event(), and the game
+/// calls input_begin_tick() and input_end_tick() around every tick. Key
+/// changes are timestamped with the tick they are seen by, so a recording
+/// played back reproduces the session exactly.
+///
+/// A recording is a text file. The first line is a header with the
+/// format version and the epoch of the game clock, then every line is a
+/// "tick key pressed" event, and the last one is "end tick".
+
+#include "pch.h"
+
+#include "game.h"
+#include "growable_buffer2.h"
+#include "input.h"
+
+/// @addtogroup input
+/// @{
+
+/// Version of the recording format.
+static const int k_input_version = 1;
+
+/// A key change.
+struct input_event
+{
+	/// Tick the change is seen by.
+	long long tick;
+
+	/// The key.
+	int key;
+
+	/// Whether it was pressed or released.
+	bool pressed;
+};
+
+DEFINE_GROWABLE_BUFFER(struct input_event, input_event_buffer)
+
+/// Input state.
+static struct
+{
+	/// Index of the current tick.
+	long long tick;
+
+	/// Recording being written, NULL if not recording.
+	FILE* record;
+
+	/// Events of the recording being played.
+	struct input_event_buffer events;
+
+	/// Index of the next event to play.
+	int next_event;
+
+	/// Tick the recording being played ends at, -1 if not playing.
+	long long play_end;
+} s_input = { .play_end = -1 };
+
+/// Apply a key change to the key states.
+///
+/// Sets changed state unconditionally, and down state if the key
+/// was pressed. The first change of a key in a tick is added to the
+/// list of changes.
+///
+/// @param[in] key Key to change state of.
+/// @param[in] pressed Whether it was pressed or released.
+static void apply_key_event(int key, bool pressed)
+{
+	key &= 0xFF;
+	const int word = key >> 5;
+	const uint32_t bit = 1u << (key & 31);
+
+	if (!(g_keys.changed[word] & bit))
+	{
+		g_keys.changed[word] |= bit;
+		g_keys.changes[g_keys.change_count++] = (uint8_t)key;
+	}
+
+	if (pressed)
+		g_keys.down[word] |= bit;
+	else
+		g_keys.down[word] &= ~bit;
+}
+
+/// Report a key change from the platform.
+///
+/// The change is seen by the next tick. Ignored while a recording is
+/// played, so the run only sees the recorded input.
+///
+/// @param[in] key Key to change state of.
+/// @param[in] pressed Whether it was pressed or released.
+void input_key_event(int key, bool pressed)
+{
+	if (s_input.play_end >= 0)
+		return;
+
+	apply_key_event(key, pressed);
+	if (s_input.record)
+		fprintf(s_input.record, "%lld %d %d\n", s_input.tick, key & 0xFF,
+			(int)pressed);
+}
+
+/// Called before every tick.
+///
+/// Applies the events of the recording being played for this tick.
+void input_begin_tick(void)
+{
+	while (s_input.next_event < s_input.events.size)
+	{
+		const struct input_event* event =
+			&s_input.events.mem[s_input.next_event];
+		if (event->tick > s_input.tick)
+			break;
+
+		input_key_event(event->key, event->pressed);
+		++s_input.next_event;
+	}
+}
+
+/// Called after every tick.
+///
+/// Clears the fresh state change flags from the keys.
+void input_end_tick(void)
+{
+	memset(g_keys.changed, 0, sizeof(g_keys.changed));
+	g_keys.change_count = 0;
+	++s_input.tick;
+}
+
+/// Start recording key changes.
+///
+/// @param[in] path File to write the recording to.
+/// @param[in] epoch Epoch of the game clock, stored in the recording.
+/// @return True if succeeded.
+bool input_record_start(const char* path, time_t epoch)
+{
+	assert(!s_input.record);
+	s_input.record = fopen(path, "w");
+	if (!s_input.record)
+		return false;
+
+	fprintf(s_input.record, "natomix-input %d %lld\n", k_input_version,
+		(long long)epoch);
+	return true;
+}
+
+/// Finish the recording.
+void input_record_stop(void)
+{
+	if (!s_input.record)
+		return;
+
+	fprintf(s_input.record, "end %lld\n", s_input.tick);
+	const int result = fclose(s_input.record);
+	assert(result == 0);
+	(void)result;
+	s_input.record = NULL;
+}
+
+/// Start playing a recording.
+///
+/// Must be called before the first tick, so ticks line up with the
+/// recording.
+///
+/// @param[in] path File to read the recording from.
+/// @param[out] epoch Epoch of the game clock in the recording.
+/// @return True if succeeded.
+bool input_play_start(const char* path, time_t* epoch)
+{
+	FILE* fp = fopen(path, "r");
+	if (!fp)
+		return false;
+
+	int version;
+	long long epoch_value;
+	bool ok = fscanf(fp, "natomix-input %d %lld", &version, &epoch_value) == 2
+		&& version == k_input_version;
+
+	input_event_buffer_init(&s_input.events);
+	s_input.next_event = 0;
+	s_input.play_end = -1;
+	while (ok)
+	{
+		struct input_event event;
+		int pressed;
+		if (fscanf(fp, "%lld %d %d", &event.tick, &event.key, &pressed) == 3)
+		{
+			event.pressed = !!pressed;
+			input_event_buffer_push(&s_input.events, &event);
+		}
+		else
+		{
+			ok = fscanf(fp, " end %lld", &s_input.play_end) == 1;
+			break;
+		}
+	}
+
+	fclose(fp);
+	if (!ok)
+	{
+		input_event_buffer_free(&s_input.events, NULL);
+		s_input.play_end = -1;
+		return false;
+	}
+
+	*epoch = (time_t)epoch_value;
+	return true;
+}
+
+/// Check whether the recording being played ended.
+///
+/// @return True if every tick of the recording was played.
+bool input_play_finished(void)
+{
+	return s_input.play_end >= 0 && s_input.tick >= s_input.play_end;
+}
+
+/// @}
@@ -0,0 +1,25 @@
+/// @file input.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Platform independent input, with recording and playback.
+
+#pragma once
+
+/// @addtogroup input
+/// @{
+
+extern void input_key_event(int key, bool pressed);
+
+extern void input_begin_tick(void);
+
+extern void input_end_tick(void);
+
+extern bool input_record_start(const char* path, time_t epoch);
+
+extern void input_record_stop(void);
+
+extern bool input_play_start(const char* path, time_t* epoch);
+
+extern bool input_play_finished(void);
+
+/// @}
@@ -25,7 +25,7 @@ enum bond_type
 	Bond_LeftTriple		= 1 << 15
 };
 
-inline uint16_t bond_char_to_flag(const char c)
+static inline uint16_t bond_char_to_flag(const char c)
 {
 	switch(c)
 	{
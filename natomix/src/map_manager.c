@@ -5,7 +5,9 @@
 
 #include "pch.h"
 
+#include "globals.h"
 #include "map.h"
+#include "trace.h"
 
 struct pack_head
 {
@@ -22,6 +24,7 @@ static struct
 
 void mapmgr_init(void)
 {
+	const long long span = trace_begin();
 	FILE* fp = fopen("packs.map", "rb");
 	uint32_t packcount;
 	fread(&packcount, sizeof(packcount), 1, fp);
@@ -40,11 +43,12 @@ void mapmgr_init(void)
 		fread(s_packs.packs[i].levels, sizeof(*s_packs.packs[i].levels),
 			levelcount, fp);
 	}
+	trace_end("mapmgr_init", span);
 }
 
 int mapmgr_get_pack_names(char packs[][32], const int size)
 {
-	const int count = min(s_packs.count, size);
+	const int count = MIN(s_packs.count, size);
 	for(int i = 0; i < count; ++i)
 		strcpy_s(packs[i], 32, s_packs.packs[i].name);
 	return count;
@@ -35,17 +35,17 @@ static bool do_menu_behavior(const char* const* choices, int count, int* selecti
 		render_print(g_font, x, y, to_print);
 	}
 
-	if(g_key_states[Key_Up] == KeyState_Pressed)
+	if(is_key_pressed(Key_Up))
 		select--;
 
-	if(g_key_states[Key_Down] == KeyState_Pressed)
+	if(is_key_pressed(Key_Down))
 		select++;
 
 	select = (select + count) % count;
 
 	*selection = select;
 
-	return g_key_states[Key_Return] == KeyState_Pressed;
+	return is_key_pressed(Key_Return);
 }
 
 void do_menu(void)
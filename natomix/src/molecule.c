@@ -0,0 +1,99 @@
+/// @file molecule.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Matching the molecule of a map against its arena.
+///
+/// The molecule is stored as a list of its non-empty cells, so matching
+/// a placement only looks at the cells that matter. Since empty cells
+/// match anything, taking an atom away never completes the molecule,
+/// and an atom landing can only complete it through placements covering
+/// the landed cell.
+
+#include "pch.h"
+
+#include "molecule.h"
+
+/// @addtogroup molecule
+/// @{
+
+/// Collect the non-empty cells of a molecule grid.
+///
+/// @param[out] molecule Molecule to initialize.
+/// @param[in] grid The molecule grid of a map.
+void molecule_init(struct molecule* molecule, const char grid[16][16])
+{
+	molecule->cell_count = 0;
+	for (int i = 0; i < 16; ++i)
+		for (int j = 0; j < 16; ++j)
+			if (grid[i][j])
+			{
+				struct molecule_cell* cell =
+					&molecule->cells[molecule->cell_count++];
+				cell->x = (int8_t)i;
+				cell->y = (int8_t)j;
+				cell->id = grid[i][j];
+			}
+}
+
+/// Check if the molecule is in the arena with its grid at a position.
+///
+/// @param[in] molecule The molecule.
+/// @param[in] arena The arena.
+/// @param[in] x Column of the molecule grid's origin.
+/// @param[in] y Row of the molecule grid's origin.
+/// @return True if every cell of the molecule matches.
+bool molecule_matches_at(const struct molecule* molecule,
+	const char arena[32][32], int x, int y)
+{
+	if (x < 0 || y < 0)
+		return false;
+
+	for (int i = 0; i < molecule->cell_count; ++i)
+	{
+		const struct molecule_cell* cell = &molecule->cells[i];
+		const int cx = x + cell->x;
+		const int cy = y + cell->y;
+		if (cx >= 32 || cy >= 32 || arena[cx][cy] != cell->id)
+			return false;
+	}
+	return true;
+}
+
+/// Check if the molecule is anywhere in the arena.
+///
+/// @param[in] molecule The molecule.
+/// @param[in] arena The arena.
+/// @return True if the molecule matches at any position.
+bool molecule_find(const struct molecule* molecule, const char arena[32][32])
+{
+	for (int i = 0; i < 32; ++i)
+		for (int j = 0; j < 32; ++j)
+			if (molecule_matches_at(molecule, arena, i, j))
+				return true;
+	return false;
+}
+
+/// Check if the molecule is in the arena covering a cell.
+///
+/// Only tries the placements where a cell of the molecule with the same
+/// atom lies on the given cell.
+///
+/// @param[in] molecule The molecule.
+/// @param[in] arena The arena.
+/// @param[in] x Column of the cell.
+/// @param[in] y Row of the cell.
+/// @return True if the molecule matches at such a position.
+bool molecule_find_through(const struct molecule* molecule,
+	const char arena[32][32], int x, int y)
+{
+	for (int i = 0; i < molecule->cell_count; ++i)
+	{
+		const struct molecule_cell* cell = &molecule->cells[i];
+		if (cell->id == arena[x][y] && molecule_matches_at(molecule, arena,
+			x - cell->x, y - cell->y))
+			return true;
+	}
+	return false;
+}
+
+/// @}
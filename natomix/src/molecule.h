@@ -0,0 +1,46 @@
+/// @file molecule.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Matching the molecule of a map against its arena.
+
+#pragma once
+#include "map.h"
+
+/// @addtogroup molecule
+/// @{
+
+/// A non-empty cell of a molecule.
+struct molecule_cell
+{
+	/// Column in the molecule grid.
+	int8_t x;
+
+	/// Row in the molecule grid.
+	int8_t y;
+
+	/// Atom id that has to be there.
+	char id;
+};
+
+/// The non-empty cells of a molecule, for matching.
+struct molecule
+{
+	/// Cells of the molecule, in grid order.
+	struct molecule_cell cells[16 * 16];
+
+	/// Count of cells.
+	int cell_count;
+};
+
+extern void molecule_init(struct molecule* molecule, const char grid[16][16]);
+
+extern bool molecule_matches_at(const struct molecule* molecule,
+	const char arena[32][32], int x, int y);
+
+extern bool molecule_find(const struct molecule* molecule,
+	const char arena[32][32]);
+
+extern bool molecule_find_through(const struct molecule* molecule,
+	const char arena[32][32], int x, int y);
+
+/// @}
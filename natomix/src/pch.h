@@ -15,4 +15,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
-#include <stdarg.h>
\ No newline at end of file
+#include <stdarg.h>
+
+#ifndef _MSC_VER
+// The few bounds checked functions we use, for other C libraries
+#define strcpy_s(dst, size, src) ((void)snprintf((dst), (size), "%s", (src)))
+#define vsprintf_s vsnprintf
+#define localtime_s(tm, time) ((void)localtime_r((time), (tm)))
+#endif
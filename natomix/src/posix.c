@@ -0,0 +1,365 @@
+/// @file posix.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Headless platform backend for POSIX systems
+///
+/// Runs the game without a window, for a fixed number of ticks or until
+/// the game quits. Useful for benchmarking and for checking the rendered
+/// output on machines without Windows.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pch.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "globals.h"
+#include "game.h"
+#include "render.h"
+#include "input.h"
+#include "telemetry.h"
+#include "trace.h"
+
+/// @addtogroup posix
+/// @{
+
+/// Nanoseconds in a second.
+static const long long k_nanoseconds = 1000000000LL;
+
+/// Command line options.
+struct options
+{
+	/// Directory holding the game data, or NULL for the current one.
+	const char* data_dir;
+
+	/// Number of ticks to run, or 0 to run until the game quits.
+	long long ticks;
+
+	/// Run ticks back to back instead of at k_tickrate.
+	bool unthrottled;
+
+	/// Only simulate, render nothing but the frames saved.
+	bool no_render;
+
+	/// Number of render threads, or 0 for the default.
+	int threads;
+
+	/// Where to save the last frame as a PPM image, or NULL.
+	const char* screenshot;
+
+	/// Where to append every frame as raw RGBA, or NULL.
+	const char* dump;
+
+	/// Where to record the input, or NULL.
+	const char* record;
+
+	/// Recorded input to play, or NULL.
+	const char* play;
+
+	/// Print the stage timings on exit.
+	bool telemetry;
+
+	/// Where to write a trace of the run, or NULL.
+	const char* trace;
+};
+
+/// Set by SIGUSR1 to print the stage timings.
+static volatile sig_atomic_t s_report_requested;
+
+/// Sleep until a monotonic time.
+///
+/// Sleeps again when interrupted by a signal, reports any other error.
+///
+/// @param[in] deadline Monotonic time in nanoseconds.
+/// @return True if succeeded.
+static bool sleep_until(long long deadline)
+{
+	struct timespec ts;
+	ts.tv_sec = (time_t)(deadline / k_nanoseconds);
+	ts.tv_nsec = (long)(deadline % k_nanoseconds);
+	int result;
+	do
+		result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	while (result == EINTR);
+	if (result != 0)
+		fprintf(stderr, "clock_nanosleep: %s\n", strerror(result));
+	return result == 0;
+}
+
+/// Ask for a telemetry report.
+///
+/// @param[in] sig The signal.
+static void request_report(int sig)
+{
+	(void)sig;
+	s_report_requested = 1;
+}
+
+/// Print a line of the telemetry report.
+///
+/// @param[in] line The line.
+static void print_report_line(const char* line)
+{
+	fputs(line, stderr);
+}
+
+/// Save a frame as a binary PPM.
+///
+/// @param[in] path File to write.
+/// @param[in] pixels The frame.
+/// @return True if succeeded.
+static bool write_screenshot(const char* path, const struct color* pixels)
+{
+	FILE* fp = fopen(path, "wb");
+	if (!fp)
+		return false;
+	fprintf(fp, "P6\n%d %d\n255\n", k_pixel_width, k_pixel_height);
+	for (int i = 0; i < k_pixel_width * k_pixel_height; ++i)
+	{
+		const uint8_t rgb[3] = { pixels[i].r, pixels[i].g, pixels[i].b };
+		fwrite(rgb, 1, sizeof(rgb), fp);
+	}
+	return fclose(fp) == 0;
+}
+
+/// Append a frame to a dump as raw RGBA.
+///
+/// @param[in] fp File to append to.
+/// @param[in] pixels The frame.
+static void write_dump_frame(FILE* fp, const struct color* pixels)
+{
+#if COLOR_ORDER_BGRA
+	struct color row[k_pixel_width];
+	for (int y = 0; y < k_pixel_height; ++y)
+	{
+		for (int x = 0; x < k_pixel_width; ++x)
+		{
+			const struct color c = pixels[y * k_pixel_width + x];
+			row[x] = color_rgba(c.b, c.g, c.r, c.a);
+		}
+		fwrite(row, sizeof(*row), k_pixel_width, fp);
+	}
+#else
+	fwrite(pixels, sizeof(*pixels), k_pixel_width * k_pixel_height, fp);
+#endif
+}
+
+/// Print usage.
+///
+/// @param[in] name Program name.
+static void print_usage(const char* name)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --data DIR         directory holding the game data\n"
+		"  --ticks N          stop after N ticks\n"
+		"  --unthrottled      do not wait between ticks\n"
+		"  --no-render        do not render, except frames saved\n"
+		"  --threads N        number of render threads\n"
+		"  --screenshot FILE  save the last frame as PPM\n"
+		"  --dump FILE        save every frame as raw RGBA\n"
+		"  --record FILE      record the input\n"
+		"  --play FILE        play recorded input, stop when it ends\n"
+		"  --telemetry        print stage timings and pixels touched on exit\n"
+		"                     or SIGUSR1\n"
+		"  --trace FILE       write a trace event JSON of the run\n",
+		name);
+}
+
+/// Parse the command line.
+///
+/// @param[in] argc Argument count.
+/// @param[in] argv Arguments.
+/// @param[out] opts Parsed options.
+/// @return True if succeeded.
+static bool parse_options(int argc, char** argv, struct options* opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (!strcmp(arg, "--unthrottled"))
+		{
+			opts->unthrottled = true;
+			continue;
+		}
+
+		if (!strcmp(arg, "--no-render"))
+		{
+			opts->no_render = true;
+			continue;
+		}
+
+		if (!strcmp(arg, "--telemetry"))
+		{
+			opts->telemetry = true;
+			continue;
+		}
+
+		if (!value)
+			return false;
+		++i;
+
+		if (!strcmp(arg, "--data"))
+			opts->data_dir = value;
+		else if (!strcmp(arg, "--ticks"))
+			opts->ticks = atoll(value);
+		else if (!strcmp(arg, "--threads"))
+			opts->threads = atoi(value);
+		else if (!strcmp(arg, "--screenshot"))
+			opts->screenshot = value;
+		else if (!strcmp(arg, "--dump"))
+			opts->dump = value;
+		else if (!strcmp(arg, "--record"))
+			opts->record = value;
+		else if (!strcmp(arg, "--play"))
+			opts->play = value;
+		else if (!strcmp(arg, "--trace"))
+			opts->trace = value;
+		else
+			return false;
+	}
+	return true;
+}
+
+/// Application entry point.
+///
+/// @param[in] argc Argument count.
+/// @param[in] argv Arguments.
+/// @return 0 if succeeded.
+int main(int argc, char** argv)
+{
+	struct options opts;
+	if (!parse_options(argc, argv, &opts))
+	{
+		print_usage(argv[0]);
+		return 2;
+	}
+
+	if (opts.data_dir && chdir(opts.data_dir) != 0)
+	{
+		perror(opts.data_dir);
+		return 1;
+	}
+
+	if (opts.trace)
+	{
+		if (!trace_start(opts.trace))
+		{
+			perror(opts.trace);
+			return 1;
+		}
+		trace_name_thread("game");
+	}
+
+	FILE* dump = NULL;
+	if (opts.dump)
+	{
+		dump = fopen(opts.dump, "wb");
+		if (!dump)
+		{
+			perror(opts.dump);
+			trace_stop();
+			return 1;
+		}
+	}
+
+	on_game_start();
+
+	if (opts.threads > 0)
+		render_set_threads(opts.threads);
+
+	// From here on failures go through the cleanup at the end
+	bool failed = false;
+	if (opts.play)
+	{
+		time_t epoch;
+		if (input_play_start(opts.play, &epoch))
+			on_game_set_epoch(epoch);
+		else
+		{
+			fprintf(stderr, "%s: not a valid recording\n", opts.play);
+			failed = true;
+		}
+	}
+
+	if (!failed && opts.record
+		&& !input_record_start(opts.record, on_game_get_epoch()))
+	{
+		perror(opts.record);
+		failed = true;
+	}
+
+	if (opts.telemetry)
+		signal(SIGUSR1, &request_report);
+
+	const long long interval = k_nanoseconds / k_tickrate;
+	const long long start = telemetry_now();
+	long long ticks = 0;
+
+	while (!failed && g_running && (!opts.ticks || ticks < opts.ticks)
+		&& !input_play_finished())
+	{
+		on_game_tick();
+		if (!opts.no_render || dump)
+			on_game_render(k_tick_fraction_one);
+		++ticks;
+
+		// Only wait for the render thread if we need its output
+		if (dump)
+		{
+			const long long present_start = telemetry_now();
+			const struct color* pixels = on_game_acquire_frame(true);
+			write_dump_frame(dump, pixels);
+			on_game_release_frame();
+			telemetry_record(TelemetryStage_Present,
+				telemetry_now() - present_start);
+		}
+
+		if (s_report_requested)
+		{
+			s_report_requested = 0;
+			telemetry_report(&print_report_line);
+		}
+
+		if (!opts.unthrottled && !sleep_until(start + ticks * interval))
+		{
+			failed = true;
+			break;
+		}
+	}
+
+	const long long elapsed = telemetry_now() - start;
+
+	if (opts.screenshot && ticks)
+	{
+		if (opts.no_render && !dump)
+			on_game_render(k_tick_fraction_one);
+		const struct color* pixels = on_game_acquire_frame(true);
+		if (pixels && !write_screenshot(opts.screenshot, pixels))
+			perror(opts.screenshot);
+		on_game_release_frame();
+	}
+
+	input_record_stop();
+	on_game_end();
+	trace_stop();
+
+	if (opts.telemetry)
+		telemetry_report(&print_report_line);
+
+	if (dump)
+		fclose(dump);
+
+	printf("%lld ticks in %.3f s (%.1f ticks/s)\n", ticks,
+		(double)elapsed / k_nanoseconds,
+		elapsed ? (double)ticks * k_nanoseconds / elapsed : 0.0);
+
+	return failed ? 1 : 0;
+}
+
+/// @}
@@ -0,0 +1,68 @@
+/// @file rect.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief An axis aligned rectangle.
+///
+/// Header only implementation of a rectangle of pixels, used for
+/// clipping.
+
+#pragma once
+
+/// @addtogroup rect
+/// @{
+
+/// An axis aligned rectangle. Right and bottom are exclusive.
+struct rect
+{
+	/// First column.
+	int left;
+
+	/// First row.
+	int top;
+
+	/// Column after the last.
+	int right;
+
+	/// Row after the last.
+	int bottom;
+};
+
+/// Creates a rectangle.
+///
+/// @param[in] left First column.
+/// @param[in] top First row.
+/// @param[in] right Column after the last.
+/// @param[in] bottom Row after the last.
+/// @return The rectangle.
+static inline struct rect rect_create(int left, int top, int right, int bottom)
+{
+	struct rect r;
+	r.left = left;
+	r.top = top;
+	r.right = right;
+	r.bottom = bottom;
+	return r;
+}
+
+/// Intersects two rectangles.
+///
+/// @param[in] a First rectangle.
+/// @param[in] b Second rectangle.
+/// @return The intersection, may be empty.
+static inline struct rect rect_intersect(struct rect a, struct rect b)
+{
+	return rect_create(MAX(a.left, b.left), MAX(a.top, b.top),
+		MIN(a.right, b.right), MIN(a.bottom, b.bottom));
+}
+
+/// Area of a rectangle.
+///
+/// @param[in] r The rectangle.
+/// @return Area in pixels, 0 if empty.
+static inline int rect_area(struct rect r)
+{
+	return r.right > r.left && r.bottom > r.top
+		? (r.right - r.left) * (r.bottom - r.top) : 0;
+}
+
+/// @}
@@ -12,6 +12,14 @@
 #include "sprite_manager.h"
 #include "game.h"
 #include "tile_manager.h"
+#include "growable_buffer2.h"
+#include "rect.h"
+#include "fnv.h"
+#include "thread_pool.h"
+#include "text_cache.h"
+#include "thread.h"
+#include "telemetry.h"
+#include "trace.h"
 
 /// @addtogroup render
 /// @{
@@ -25,11 +33,26 @@ enum render_cmd_type
 };
 
 
+enum
+{
+	/// Alignment of the commands in the command buffer.
+	k_cmd_align = 8,
+
+	/// Maximum count of strips the bitmap is split into.
+	k_max_strips = 64,
+
+	/// Strips per rendering thread, so threads finishing early can
+	/// help out with the rest.
+	k_strips_per_thread = 4,
+};
+
 /// Head of a render command.
 struct render_cmd_head
 {
-	/// Pointer to the next command. NULL if last.
-	struct render_cmd_head* next;
+	/// Size of the whole command in bytes, including padding.
+	///
+	/// The next command starts this many bytes after the head.
+	int size;
 
 	/// The type of the command.
 	enum render_cmd_type type;
@@ -65,6 +88,18 @@ struct render_cmd_tile
 
 	/// ID of the tile to draw.
 	int tile_id;
+
+	/// Horizontal distance moved since the previous tick.
+	int motion_x;
+
+	/// Vertical distance moved since the previous tick.
+	int motion_y;
+
+	/// Interpolated horizontal position, filled in by the render thread.
+	int draw_x;
+
+	/// Interpolated vertical position, filled in by the render thread.
+	int draw_y;
 };
 
 /// Command to render a string.
@@ -85,6 +120,11 @@ struct render_cmd_string
 	/// string.
 	int font_sprite;
 
+	/// Cached raster of the string, filled in by the render thread.
+	///
+	/// NULL if the string is drawn glyph by glyph.
+	const struct text_raster* raster;
+
 	/// Length of the string.
 	int len;
 
@@ -92,63 +132,219 @@ struct render_cmd_string
 	char str[1];
 };
 
-/// Head of the linked list of render commands.
-struct render_cmds
+DEFINE_GROWABLE_BUFFER(uint8_t, render_cmd_buffer)
+
+/// The render commands of a frame.
+struct render_frame
+{
+	/// The commands, stored back to back.
+	///
+	/// The buffer is never shrunk, so after the first few frames adding
+	/// commands does not allocate anymore.
+	struct render_cmd_buffer cmds;
+
+	/// Tile ID of the background, -1 if none.
+	int background;
+
+	/// Fraction of a tick to interpolate moving tiles with.
+	int fraction;
+};
+
+/// Frames of commands. The game builds one while the render thread
+/// rasterizes the other, then they are swapped.
+static struct render_frame s_frames[2];
+
+/// Index of the frame the game builds.
+static int s_building;
+
+/// True if the building frame has commands not yet submitted.
+static bool s_building_fresh;
+
+/// A framebuffer the frames are rasterized into.
+struct render_target
+{
+	/// The pixels.
+	struct color pixels[k_pixel_width * k_pixel_height];
+
+	/// Hash of the draws touching each 8x8 cell, for the frame in the
+	/// pixels.
+	fnv_t cell_hashes[k_height_in_sprite][k_width_in_sprite];
+
+	/// False until the pixels hold a completely rendered frame.
+	bool valid;
+};
+
+/// Framebuffers, the render thread draws into one while the platform
+/// presents the other.
+static struct render_target s_targets[2];
+
+/// State shared by the game and the render thread.
+static struct
 {
-	/// First element, NULL if none.
-	struct render_cmd_head* first;
+	/// Guards everything here.
+	struct mutex mutex;
+
+	/// Signaled when a frame is submitted, rasterized or released.
+	struct cond cond;
+
+	/// The render thread.
+	struct thread thread;
+
+	/// True while the render thread has a frame to rasterize.
+	bool busy;
+
+	/// True when the render thread should exit.
+	bool stop;
 
-	/// Last element. May be invalid if first is NULL.
-	struct render_cmd_head* last;
-} s_cmds;
+	/// Index of the newest completely rendered target, -1 if none.
+	int front;
+
+	/// Incremented every time a new frame becomes the front.
+	int front_serial;
+
+	/// Index of the target held by the platform, -1 if none.
+	int acquired;
+
+	/// Value of front_serial when a frame was last acquired.
+	int acquired_serial;
+} s_render;
+
+/// A background tile composited onto black.
+struct background_layer
+{
+	/// ID of the tile the layer was made from.
+	int tile_id;
+
+	/// The composited pixels, same size as a render target.
+	struct color* pixels;
+};
+
+DEFINE_GROWABLE_BUFFER(struct background_layer, background_layer_buffer)
+
+/// Every background layer composited so far.
+static struct background_layer_buffer s_backgrounds;
+
+/// Pixels of the target being rasterized.
+static struct color* s_bitmap;
+
+/// Whether a cell is rasterized again in the current frame.
+static bool s_dirty[k_height_in_sprite][k_width_in_sprite];
+
+/// Count of pixels written by the frame being rasterized.
+static int s_pixels_touched;
+
+DEFINE_GROWABLE_BUFFER(int, render_offset_buffer)
+
+/// A horizontal strip of the bitmap, rasterized by a single thread.
+struct render_strip
+{
+	/// Pixels of the bitmap covered by the strip.
+	struct rect area;
+
+	/// Offsets of the commands touching the strip, in drawing order.
+	struct render_offset_buffer cmds;
+
+	/// Count of pixels written while rasterizing the strip.
+	int pixels_touched;
+};
+
+/// What the strips of a frame are rasterized from.
+struct render_pass
+{
+	/// The frame being rasterized.
+	const struct render_frame* frame;
+
+	/// The background layer of the frame, NULL if none.
+	const struct color* background;
+};
+
+/// Strips of the current frame.
+static struct render_strip s_strips[k_max_strips];
+
+/// Count of threads rasterizing, 1 for serial.
+static int s_render_threads = 1;
 
 /// Add a new render command.
 ///
-/// Allocates and adds a new render command struct of the desired size,
-/// and initializes it.
+/// Reserves space for a new render command of the desired size at the
+/// end of the command buffer, and initializes its head.
 ///
 /// @param[in] type Type of the render command to create.
 /// @param[in] size Size of the new render command.
 /// @return Pointer to the newly created command.
+/// @warning The pointer is only valid until the next command is added.
 static struct render_cmd_head* add_new_cmd(enum render_cmd_type type,
 	int size)
 {
-	struct render_cmd_head* cmd = (struct render_cmd_head*)malloc(size);
-	assert(cmd);
-	if (!s_cmds.first)
-	{
-		s_cmds.first = cmd;
-		s_cmds.last = cmd;
-	}
-	else
-	{
-		s_cmds.last->next = cmd;
-		s_cmds.last = cmd;
-	}
-	cmd->next = NULL;
+	struct render_cmd_buffer* cmds = &s_frames[s_building].cmds;
+	const int aligned = (size + k_cmd_align - 1) & ~(k_cmd_align - 1);
+	const int offset = render_cmd_buffer_grow(cmds, aligned);
+	struct render_cmd_head* cmd =
+		(struct render_cmd_head*)&cmds->mem[offset];
+	cmd->size = aligned;
 	cmd->type = type;
 	return cmd;
 }
 
+static void render_thread(void* arg);
+
 /// Initialize the render manager
+///
+/// Starts the render thread.
 void render_init(void)
 {
-	s_cmds.first = NULL;
-	s_cmds.last = NULL;
+	for (int i = 0; i < 2; ++i)
+	{
+		render_cmd_buffer_init(&s_frames[i].cmds);
+		s_frames[i].background = -1;
+		s_frames[i].fraction = k_tick_fraction_one;
+	}
+	background_layer_buffer_init(&s_backgrounds);
+	for (int i = 0; i < k_max_strips; ++i)
+		render_offset_buffer_init(&s_strips[i].cmds);
+
+	mutex_init(&s_render.mutex);
+	cond_init(&s_render.cond);
+	s_render.front = -1;
+	s_render.acquired = -1;
+	const bool result = thread_create(&s_render.thread, &render_thread, NULL);
+	assert(result);
+	(void)result;
+}
+
+/// Stop the render thread.
+///
+/// Frames submitted before are still rasterized.
+void render_end(void)
+{
+	mutex_lock(&s_render.mutex);
+	s_render.stop = true;
+	cond_broadcast(&s_render.cond);
+	mutex_unlock(&s_render.mutex);
+	thread_join(&s_render.thread);
+	thread_pool_stop();
 }
 
 /// Start a new series of render commands.
+///
+/// Drops the commands of the previous frame, but keeps the memory.
 void render_start_frame(void)
 {
-	struct render_cmd_head* it = s_cmds.first;
-	while (it != NULL)
-	{
-		struct render_cmd_head* next = it->next;
-		free(it);
-		it = next;
-	}
-	s_cmds.first = NULL;
-	s_cmds.last = NULL;
+	s_frames[s_building].cmds.size = 0;
+	s_frames[s_building].background = -1;
+	s_building_fresh = true;
+}
+
+/// Set the background of the frame.
+///
+/// The tile is drawn at the top left corner before every other
+/// command. Backgrounds never change, so each one is only composited
+/// once, and copied to the bitmap on later frames.
+///
+/// @param[in] id Tile id to use as background.
+void render_background(int id)
+{
+	s_frames[s_building].background = id;
 }
 
 /// Draw a sprite.
@@ -172,6 +368,22 @@ void render_sprite(int id, int x, int y)
 /// @param[in] x Vertical position.
 /// @param[in] y Horizontal position.
 void render_tile(int id, int x, int y)
+{
+	render_tile_moving(id, x, y, x, y);
+}
+
+/// Draw a tile that moved since the previous tick.
+///
+/// When rendering between two ticks the tile is drawn between its
+/// previous and current position, so movement stays smooth at any
+/// presentation rate.
+///
+/// @param[in] id Tile id to draw.
+/// @param[in] x Vertical position.
+/// @param[in] y Horizontal position.
+/// @param[in] from_x Vertical position on the previous tick.
+/// @param[in] from_y Horizontal position on the previous tick.
+void render_tile_moving(int id, int x, int y, int from_x, int from_y)
 {
 	struct render_cmd_tile* cmd = (struct render_cmd_tile*)
 		add_new_cmd(RenderCmd_Tile, sizeof(struct render_cmd_tile));
@@ -179,6 +391,10 @@ void render_tile(int id, int x, int y)
 	cmd->x = x;
 	cmd->y = y;
 	cmd->tile_id = id;
+	cmd->motion_x = x - from_x;
+	cmd->motion_y = y - from_y;
+	cmd->draw_x = x;
+	cmd->draw_y = y;
 }
 
 /// Render text somewhere.
@@ -198,68 +414,623 @@ void render_print(int font_spr, int x, int y, const char* str)
 	cmd->x = x;
 	cmd->y = y;
 	cmd->font_sprite = font_spr;
+	cmd->raster = NULL;
 	cmd->len = size - 1;
 	strcpy_s(cmd->str, size, str);
 }
 
+/// Get the cell of a pixel coordinate.
+///
+/// @param[in] px The coordinate, may be negative.
+/// @return The cell, rounded towards negative infinity.
+static inline int cell_of(int px)
+{
+	return (px >= 0 ? px : px - (k_sprite_size - 1)) / k_sprite_size;
+}
+
+/// Get the pixels of a cell.
+///
+/// @param[in] column Column of the cell.
+/// @param[in] row Row of the cell.
+/// @return The rectangle covered by the cell.
+static inline struct rect cell_rect(int column, int row)
+{
+	return rect_create(column * k_sprite_size, row * k_sprite_size,
+		(column + 1) * k_sprite_size, (row + 1) * k_sprite_size);
+}
+
+/// Mix a draw into the hash of every cell it touches.
+///
+/// @param[in,out] hashes Cell hashes of the frame.
+/// @param[in] type Type of the command drawing.
+/// @param[in] id ID of what is drawn.
+/// @param[in] x Horizontal position.
+/// @param[in] y Vertical position.
+/// @param[in] w Width in pixels.
+/// @param[in] h Height in pixels.
+static void hash_draw(fnv_t hashes[][k_width_in_sprite],
+	enum render_cmd_type type, int id, int x, int y, int w, int h)
+{
+	const int values[] = { (int)type, id, x, y };
+	fnv_t draw;
+	fnv_init(&draw);
+	fnv_hash(&draw, values, sizeof(values));
+
+	const int left = MAX(cell_of(x), 0);
+	const int top = MAX(cell_of(y), 0);
+	const int right = MIN(cell_of(x + w - 1), k_width_in_sprite - 1);
+	const int bottom = MIN(cell_of(y + h - 1), k_height_in_sprite - 1);
+	for (int i = top; i <= bottom; ++i)
+		for (int j = left; j <= right; ++j)
+			fnv_hash(&hashes[i][j], &draw, sizeof(draw));
+}
+
+/// Mix a render command into the hash of every cell it touches.
+///
+/// Strings are hashed glyph by glyph, so changing a character only
+/// changes the cells of that character.
+///
+/// @param[in,out] hashes Cell hashes of the frame.
+/// @param[in] it The command.
+static void hash_cmd(fnv_t hashes[][k_width_in_sprite],
+	const struct render_cmd_head* it)
+{
+	switch (it->type)
+	{
+	case RenderCmd_Sprite:
+		{
+			const struct render_cmd_sprite* cmd =
+				(const struct render_cmd_sprite*)it;
+			hash_draw(hashes, it->type, cmd->sprite_id, cmd->x, cmd->y,
+				k_sprite_size, k_sprite_size);
+		}
+		break;
+	case RenderCmd_Tile:
+		{
+			const struct render_cmd_tile* cmd =
+				(const struct render_cmd_tile*)it;
+			const struct tile* tile = tile_manager_get_by_id(cmd->tile_id);
+			hash_draw(hashes, it->type, cmd->tile_id, cmd->draw_x, cmd->draw_y,
+				tile->width * k_sprite_size, tile->height * k_sprite_size);
+		}
+		break;
+	case RenderCmd_String:
+		{
+			const struct render_cmd_string* cmd =
+				(const struct render_cmd_string*)it;
+			for (int i = 0; i < cmd->len; ++i)
+				hash_draw(hashes, it->type,
+					cmd->font_sprite + ((uint8_t*)cmd->str)[i],
+					cmd->x + i * k_sprite_size, cmd->y,
+					k_sprite_size, k_sprite_size);
+		}
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+/// Get the rows of the bitmap a render command draws to.
+///
+/// @param[in] it The command.
+/// @param[out] top First row.
+/// @param[out] bottom Row after the last.
+static void cmd_rows(const struct render_cmd_head* it, int* top,
+	int* bottom)
+{
+	switch (it->type)
+	{
+	case RenderCmd_Sprite:
+		*top = ((const struct render_cmd_sprite*)it)->y;
+		*bottom = *top + k_sprite_size;
+		break;
+	case RenderCmd_Tile:
+		{
+			const struct render_cmd_tile* cmd =
+				(const struct render_cmd_tile*)it;
+			*top = cmd->draw_y;
+			*bottom = *top
+				+ tile_manager_get_by_id(cmd->tile_id)->height * k_sprite_size;
+		}
+		break;
+	case RenderCmd_String:
+		*top = ((const struct render_cmd_string*)it)->y;
+		*bottom = *top + k_sprite_size;
+		break;
+	default:
+		assert(false);
+		*top = 0;
+		*bottom = 0;
+		break;
+	}
+}
+
+/// Draws an image onto the bitmap.
+///
+/// @param[in] clip Rectangle to draw into.
+/// @param[in] image The image to draw.
+/// @param[in] x Vertical position.
+/// @param[in] y Horizontal position.
+typedef void(*blit_fn)(const struct rect* clip, const void* image,
+	int x, int y);
+
+/// Draws a sprite onto the target bitmap.
+static void blit_sprite(const struct rect* clip, const void* image,
+	int x, int y)
+{
+	sprite_draw_on_bitmap(s_bitmap, k_pixel_width, clip,
+		(const struct sprite*)image, x, y);
+}
+
+/// Draws a text raster onto the target bitmap.
+static void blit_text(const struct rect* clip, const void* image,
+	int x, int y)
+{
+	text_raster_draw_on_bitmap(s_bitmap, k_pixel_width, clip,
+		(const struct text_raster*)image, x, y);
+}
+
+/// Draw an image onto the dirty cells of a strip of the target bitmap.
+///
+/// Neighboring dirty cells in a row are drawn with a single blit.
+///
+/// @param[in,out] strip The strip to draw into.
+/// @param[in] blit Function drawing the image.
+/// @param[in] image The image to draw.
+/// @param[in] area Rectangle covered by the image.
+static void draw_dirty(struct render_strip* strip, blit_fn blit,
+	const void* image, struct rect area)
+{
+	const struct rect visible = rect_intersect(strip->area, area);
+	if (rect_area(visible) == 0)
+		return;
+
+	const int left = cell_of(visible.left);
+	const int right = cell_of(visible.right - 1);
+	for (int i = cell_of(visible.top); i <= cell_of(visible.bottom - 1); ++i)
+		for (int j = left; j <= right; ++j)
+		{
+			if (!s_dirty[i][j])
+				continue;
+
+			int end = j + 1;
+			while (end <= right && s_dirty[i][end])
+				++end;
+
+			const struct rect run = rect_intersect(visible,
+				rect_create(j * k_sprite_size, i * k_sprite_size,
+					end * k_sprite_size, (i + 1) * k_sprite_size));
+			blit(&run, image, area.left, area.top);
+			strip->pixels_touched += rect_area(run);
+			j = end;
+		}
+}
+
+/// Draw a sprite onto the dirty cells of a strip of the target bitmap.
+///
+/// @param[in,out] strip The strip to draw into.
+/// @param[in] sprite The sprite to draw.
+/// @param[in] x Vertical position.
+/// @param[in] y Horizontal position.
+static void draw_sprite(struct render_strip* strip,
+	const struct sprite* sprite, int x, int y)
+{
+	draw_dirty(strip, &blit_sprite, sprite,
+		rect_create(x, y, x + k_sprite_size, y + k_sprite_size));
+}
+
 /// Draw a sprite render command
+/// @param[in,out] strip The strip to draw into.
 /// @param[in] cmd The command
-static void render_draw_sprite(const struct render_cmd_sprite* cmd)
+static void render_draw_sprite(struct render_strip* strip,
+	const struct render_cmd_sprite* cmd)
 {
-	sprite_draw_on_bitmap(g_bitmap, k_pixel_width, k_pixel_height,
-		sprite_manager_get_by_id(cmd->sprite_id), cmd->x, cmd->y);
+	draw_sprite(strip, sprite_manager_get_by_id(cmd->sprite_id),
+		cmd->x, cmd->y);
 }
 
 /// Draw a tile render command
+/// @param[in,out] strip The strip to draw into.
 /// @param[in] cmd The command
-static void render_draw_tile(const struct render_cmd_tile* cmd)
+static void render_draw_tile(struct render_strip* strip,
+	const struct render_cmd_tile* cmd)
 {
-	tile_draw_on_bitmap(g_bitmap, k_pixel_width, k_pixel_height,
-		tile_manager_get_by_id(cmd->tile_id), cmd->x, cmd->y);
+	const struct tile* tile = tile_manager_get_by_id(cmd->tile_id);
+	for (int i = 0; i < tile->width; ++i)
+		for (int j = 0; j < tile->height; ++j)
+			draw_sprite(strip,
+				sprite_manager_get_by_id(tile->start_id + j * tile->width + i),
+				cmd->draw_x + i * k_sprite_size, cmd->draw_y + j * k_sprite_size);
 }
 
 /// Draw a string render command
+///
+/// Draws the cached raster of the string if there is one, glyph by
+/// glyph otherwise.
+///
+/// @param[in,out] strip The strip to draw into.
 /// @param[in] cmd The command
-static void render_draw_string(const struct render_cmd_string* cmd)
+static void render_draw_string(struct render_strip* strip,
+	const struct render_cmd_string* cmd)
 {
+	if (cmd->raster)
+	{
+		draw_dirty(strip, &blit_text, cmd->raster, rect_create(cmd->x,
+			cmd->y, cmd->x + cmd->len * k_sprite_size, cmd->y + k_sprite_size));
+		return;
+	}
+
 	for (int i = 0; i < cmd->len; ++i)
 	{
 		const int spr = cmd->font_sprite + ((uint8_t*)cmd->str)[i];
 		const int x = cmd->x + i * k_sprite_size;
 		const int y = cmd->y;
-		sprite_draw_on_bitmap(g_bitmap, k_pixel_width, k_pixel_height,
-			sprite_manager_get_by_id(spr), x, y);
+		draw_sprite(strip, sprite_manager_get_by_id(spr), x, y);
 	}
 }
 
-/// Render the current draw commands onto the global bitmap.
-void render_render(void)
+/// Rasterize a strip of the target bitmap.
+///
+/// Restores the background of the dirty cells of the strip, then draws
+/// the commands binned to it. Only touches pixels inside the strip, so
+/// strips can be rasterized in parallel.
+///
+/// @param[in] ctx The render pass.
+/// @param[in] index Index of the strip.
+static void render_strip(void* ctx, int index)
 {
-	// Paint the background black
-	for (int i = 0; i < k_pixel_width; ++i)
-		for (int j = 0; j < k_pixel_height; ++j)
-			g_bitmap[j * k_pixel_width + i] = color_rgba(0, 0, 0, 255);
+	const long long span = trace_begin();
+	const struct render_pass* pass = (const struct render_pass*)ctx;
+	const struct color* background = pass->background;
+	struct render_strip* strip = &s_strips[index];
+
+	for (int i = cell_of(strip->area.top);
+		i <= cell_of(strip->area.bottom - 1);
+		++i)
+		for (int j = 0; j < k_width_in_sprite; ++j)
+		{
+			if (!s_dirty[i][j])
+				continue;
+
+			strip->pixels_touched += k_sprite_size * k_sprite_size;
+			for (int k = 0; k < k_sprite_size; ++k)
+			{
+				const int px = (i * k_sprite_size + k) * k_pixel_width
+					+ j * k_sprite_size;
+				if (background)
+					memcpy(&s_bitmap[px], &background[px],
+						k_sprite_size * sizeof(struct color));
+				else
+					for (int l = 0; l < k_sprite_size; ++l)
+						s_bitmap[px + l] = color_rgba(0, 0, 0, 255);
+			}
+		}
 
-	for (const struct render_cmd_head* it = s_cmds.first;
-		it != NULL;
-		it = it->next)
+	for (int i = 0; i < strip->cmds.size; ++i)
 	{
+		const struct render_cmd_head* it =
+			(const struct render_cmd_head*)&pass->frame->cmds.mem[strip->cmds.mem[i]];
+
 		switch (it->type)
 		{
 		case RenderCmd_Sprite:
-			render_draw_sprite((const struct render_cmd_sprite*)it);
+			render_draw_sprite(strip, (const struct render_cmd_sprite*)it);
 			break;
 		case RenderCmd_Tile:
-			render_draw_tile((const struct render_cmd_tile*)it);
+			render_draw_tile(strip, (const struct render_cmd_tile*)it);
 			break;
 		case RenderCmd_String:
-			render_draw_string((const struct render_cmd_string*)it);
+			render_draw_string(strip, (const struct render_cmd_string*)it);
 			break;
 		default:
 			assert(false);
 			break;
 		}
 	}
+	trace_end("render strip", span);
+}
+
+/// Get the composited layer of a background.
+///
+/// Composites the background on first use.
+///
+/// @param[in] id Tile id of the background.
+/// @return Pixels of the background layer.
+static const struct color* get_background_layer(int id)
+{
+	for (int i = 0; i < s_backgrounds.size; ++i)
+		if (s_backgrounds.mem[i].tile_id == id)
+			return s_backgrounds.mem[i].pixels;
+
+	struct background_layer layer;
+	layer.tile_id = id;
+	layer.pixels = (struct color*)malloc(sizeof(s_targets[0].pixels));
+	assert(layer.pixels);
+	for (int i = 0; i < k_pixel_width * k_pixel_height; ++i)
+		layer.pixels[i] = color_rgba(0, 0, 0, 255);
+	const struct rect all = rect_create(0, 0, k_pixel_width, k_pixel_height);
+	tile_draw_on_bitmap(layer.pixels, k_pixel_width, &all,
+		tile_manager_get_by_id(id), 0, 0);
+	background_layer_buffer_push(&s_backgrounds, &layer);
+	return layer.pixels;
+}
+
+/// Interpolate the position of a moving tile.
+///
+/// @param[in,out] cmd The command.
+/// @param[in] fraction Fraction of a tick elapsed since the commands were
+///                     made, out of k_tick_fraction_one.
+static void interpolate_tile(struct render_cmd_tile* cmd, int fraction)
+{
+	const int remaining = k_tick_fraction_one - fraction;
+	cmd->draw_x = cmd->x - cmd->motion_x * remaining / k_tick_fraction_one;
+	cmd->draw_y = cmd->y - cmd->motion_y * remaining / k_tick_fraction_one;
+}
+
+/// Check whether two targets hold the same frame.
+///
+/// @param[in] a A target.
+/// @param[in] b Another target.
+/// @return True if every cell hash matches.
+static bool targets_match(const struct render_target* a,
+	const struct render_target* b)
+{
+	return a->valid && b->valid
+		&& !memcmp(a->cell_hashes, b->cell_hashes, sizeof(a->cell_hashes));
+}
+
+/// Rasterize a frame into a target.
+///
+/// Only cells whose draws differ from the frame already in the target
+/// are rasterized again, the rest is left as is. The commands are binned
+/// into horizontal strips, which are rasterized in parallel if
+/// render_set_threads() asked for more than one thread.
+///
+/// @param[in,out] frame The frame, interpolated and text cached in place.
+/// @param[in,out] target The target to draw into.
+static void rasterize_frame(struct render_frame* frame,
+	struct render_target* target)
+{
+	struct render_cmd_buffer* cmds = &frame->cmds;
+
+	static fnv_t hashes[k_height_in_sprite][k_width_in_sprite];
+	for (int i = 0; i < k_height_in_sprite; ++i)
+		for (int j = 0; j < k_width_in_sprite; ++j)
+		{
+			fnv_init(&hashes[i][j]);
+			fnv_hash(&hashes[i][j], &frame->background,
+				sizeof(frame->background));
+		}
+
+	for (int offset = 0; offset < cmds->size;)
+	{
+		struct render_cmd_head* it =
+			(struct render_cmd_head*)&cmds->mem[offset];
+		offset += it->size;
+		if (it->type == RenderCmd_Tile)
+			interpolate_tile((struct render_cmd_tile*)it, frame->fraction);
+		hash_cmd(hashes, it);
+	}
+
+	struct render_pass pass;
+	pass.frame = frame;
+	pass.background = frame->background >= 0
+		? get_background_layer(frame->background) : NULL;
+	bool any_dirty = false;
+	for (int i = 0; i < k_height_in_sprite; ++i)
+		for (int j = 0; j < k_width_in_sprite; ++j)
+		{
+			const bool dirty = !target->valid
+				|| hashes[i][j] != target->cell_hashes[i][j];
+			s_dirty[i][j] = dirty;
+			target->cell_hashes[i][j] = hashes[i][j];
+			any_dirty |= dirty;
+		}
+	target->valid = true;
+	s_pixels_touched = 0;
+
+	if (!any_dirty)
+		return;
+
+	// Split the bitmap into strips of whole cell rows
+	const int strip_goal = MIN(s_render_threads * k_strips_per_thread,
+		k_max_strips);
+	const int strip_cells =
+		(k_height_in_sprite + strip_goal - 1) / strip_goal;
+	const int strip_height = strip_cells * k_sprite_size;
+	const int strip_count =
+		(k_pixel_height + strip_height - 1) / strip_height;
+	for (int i = 0; i < strip_count; ++i)
+	{
+		s_strips[i].area = rect_create(0, i * strip_height, k_pixel_width,
+			MIN((i + 1) * strip_height, k_pixel_height));
+		s_strips[i].cmds.size = 0;
+		s_strips[i].pixels_touched = 0;
+	}
+
+	// Bin the commands into the strips they touch, keeping their order
+	text_cache_start_frame();
+	for (int offset = 0; offset < cmds->size;)
+	{
+		struct render_cmd_head* it =
+			(struct render_cmd_head*)&cmds->mem[offset];
+
+		if (it->type == RenderCmd_String)
+		{
+			struct render_cmd_string* cmd = (struct render_cmd_string*)it;
+			cmd->raster = text_cache_get(cmd->font_sprite, cmd->x, cmd->y,
+				cmd->str, cmd->len);
+		}
+
+		int top;
+		int bottom;
+		cmd_rows(it, &top, &bottom);
+		if (bottom > 0 && top < k_pixel_height)
+		{
+			const int first = MAX(top, 0) / strip_height;
+			const int last = (MIN(bottom, k_pixel_height) - 1) / strip_height;
+			for (int i = first; i <= last; ++i)
+				render_offset_buffer_push(&s_strips[i].cmds, &offset);
+		}
+
+		offset += it->size;
+	}
+
+	s_bitmap = target->pixels;
+	thread_pool_run(&render_strip, &pass, strip_count);
+
+	for (int i = 0; i < strip_count; ++i)
+		s_pixels_touched += s_strips[i].pixels_touched;
+}
+
+/// Entry point of the render thread.
+///
+/// Rasterizes every submitted frame into the target that is neither the
+/// front nor held by the platform, then makes it the front if it differs
+/// from the previous one.
+///
+/// @param[in] arg Unused.
+static void render_thread(void* arg)
+{
+	(void)arg;
+	trace_name_thread("render");
+
+	mutex_lock(&s_render.mutex);
+	for (;;)
+	{
+		while (!s_render.busy && !s_render.stop)
+			cond_wait(&s_render.cond, &s_render.mutex);
+		if (!s_render.busy)
+			break;
+
+		// The other target may still be presented from
+		const int index = s_render.front == 0 ? 1 : 0;
+		while (s_render.acquired == index)
+			cond_wait(&s_render.cond, &s_render.mutex);
+		struct render_frame* frame = &s_frames[!s_building];
+		struct render_target* target = &s_targets[index];
+		mutex_unlock(&s_render.mutex);
+
+		const long long span = trace_begin();
+		const long long start = telemetry_now();
+		rasterize_frame(frame, target);
+		telemetry_record(TelemetryStage_Rasterize, telemetry_now() - start);
+		telemetry_count(TelemetryCounter_PixelsTouched, s_pixels_touched);
+		trace_end("rasterize", span);
+
+		mutex_lock(&s_render.mutex);
+		if (s_render.front < 0
+			|| !targets_match(target, &s_targets[s_render.front]))
+		{
+			s_render.front = index;
+			++s_render.front_serial;
+		}
+		s_render.busy = false;
+		cond_broadcast(&s_render.cond);
+	}
+	mutex_unlock(&s_render.mutex);
+}
+
+/// Wait until the render thread is idle.
+///
+/// @warning Must be called with the mutex held.
+static void wait_idle_locked(void)
+{
+	while (s_render.busy)
+		cond_wait(&s_render.cond, &s_render.mutex);
+}
+
+/// Hand the current draw commands to the render thread.
+///
+/// Waits for the previous frame to be rasterized, so the game builds the
+/// commands of the next tick while the render thread draws this one.
+/// Can be called any number of times between two ticks, moving tiles
+/// are interpolated between their previous and current position.
+///
+/// @param[in] fraction Fraction of a tick elapsed since the commands were
+///                     made, out of k_tick_fraction_one.
+void render_render(int fraction)
+{
+	CLAMP_IN_PLACE(fraction, 0, k_tick_fraction_one);
+
+	const long long span = trace_begin();
+	const long long start = telemetry_now();
+	mutex_lock(&s_render.mutex);
+	wait_idle_locked();
+
+	// Without a new tick the render thread already has the commands
+	if (s_building_fresh)
+	{
+		s_building = !s_building;
+		s_building_fresh = false;
+	}
+
+	s_frames[!s_building].fraction = fraction;
+	s_render.busy = true;
+	cond_broadcast(&s_render.cond);
+	mutex_unlock(&s_render.mutex);
+	telemetry_record(TelemetryStage_Submit, telemetry_now() - start);
+	trace_end("render submit", span);
+}
+
+/// Wait until every submitted frame is rasterized.
+void render_finish(void)
+{
+	mutex_lock(&s_render.mutex);
+	wait_idle_locked();
+	mutex_unlock(&s_render.mutex);
+}
+
+/// Get the newest completely rendered frame for presenting.
+///
+/// The frame is not drawn into until render_release_frame() is called.
+/// Only one frame can be held at a time.
+///
+/// @param[in] wait Wait for every submitted frame to be rasterized, and
+///                 return the newest frame even if it was presented.
+/// @return Pixels of the frame, NULL if there is no new frame.
+const struct color* render_acquire_frame(bool wait)
+{
+	mutex_lock(&s_render.mutex);
+	assert(s_render.acquired < 0);
+	if (wait)
+		wait_idle_locked();
+
+	const struct color* pixels = NULL;
+	if (s_render.front >= 0
+		&& (wait || s_render.acquired_serial != s_render.front_serial))
+	{
+		s_render.acquired = s_render.front;
+		s_render.acquired_serial = s_render.front_serial;
+		pixels = s_targets[s_render.front].pixels;
+	}
+	mutex_unlock(&s_render.mutex);
+	return pixels;
+}
+
+/// Let the render thread draw into the acquired frame again.
+void render_release_frame(void)
+{
+	mutex_lock(&s_render.mutex);
+	s_render.acquired = -1;
+	cond_broadcast(&s_render.cond);
+	mutex_unlock(&s_render.mutex);
+}
+
+/// Set the count of threads rasterizing.
+///
+/// With more than one thread the strips of the bitmap are rasterized
+/// in parallel on a thread pool. The output is the same either way.
+///
+/// @param[in] count Count of threads, 1 for serial rendering.
+void render_set_threads(int count)
+{
+	render_finish();
+	thread_pool_stop();
+	s_render_threads = MAX(count, 1);
+	if (s_render_threads > 1)
+		thread_pool_start(s_render_threads);
 }
 
 extern void render_printf(int font_spr, int x, int y,
@@ -5,23 +5,38 @@
 
 #pragma once
 #include "globals.h"
+#include "color.h"
 
 /// @addtogroup render
 /// @{
 
 extern void render_init(void);
 
+extern void render_end(void);
+
 extern void render_start_frame(void);
 
+extern void render_background(int id);
+
 extern void render_sprite(int id, int x, int y);
 
 extern void render_tile(int id, int x, int y);
 
+extern void render_tile_moving(int id, int x, int y, int from_x, int from_y);
+
 extern void render_print(int font_spr, int x, int y, const char* str);
 
 extern void render_printf(int font_spr, int x, int y,
 	const char* fmt, ...);
 
-extern void render_render(void);
+extern void render_render(int fraction);
+
+extern void render_finish(void);
+
+extern const struct color* render_acquire_frame(bool wait);
+
+extern void render_release_frame(void);
+
+extern void render_set_threads(int count);
 
 /// @}
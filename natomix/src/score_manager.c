@@ -9,6 +9,7 @@
 #include "map.h"
 #include "score.h"
 #include "growable_buffer2.h"
+#include "trace.h"
 
 struct score_record
 {
@@ -31,27 +32,27 @@ static fnv_t uid_of_map(const struct map* const map)
 
 void scoremgr_init(void)
 {
+	const long long span = trace_begin();
 	score_record_buffer_init(&s_scores);
+	// Without the file this is the first run, with no scores yet. It is
+	// written with the first score, every exit still ends the span.
 	FILE* fp = fopen("highscores.bin", "rb");
-	if (!fp)
+	if (fp)
 	{
-		fp = fopen("highscores.bin", "wb");
-		assert(fp);
-		int result = fclose(fp);
+		int result = fseek(fp, 0L, SEEK_END);
 		assert(result == 0);
-		fp = fopen("highscores.bin", "rb");
+		const int size = ftell(fp);
+		const size_t count = (size_t)size / sizeof(struct score_record);
+		rewind(fp);
+		score_record_buffer_resize(&s_scores, (int)count);
+		const size_t result_c = fread(s_scores.mem, sizeof(struct score_record), count, fp);
+		assert(result_c == count);
+		result = fclose(fp);
+		assert(result == 0);
+		(void)result;
+		(void)result_c;
 	}
-	assert(fp);
-	int result = fseek(fp, 0L, SEEK_END);
-	assert(result == 0);
-	const int size = ftell(fp);
-	const size_t count = (size_t)size / sizeof(struct score_record);
-	rewind(fp);
-	score_record_buffer_resize(&s_scores, (int)count);
-	const size_t result_c = fread(s_scores.mem, sizeof(struct score_record), count, fp);
-	assert(result_c == count);
-	result = fclose(fp);
-	assert(result == 0);
+	trace_end("scoremgr_init", span);
 }
 
 int score_record_comparor(const void* a, const void* b)
@@ -90,7 +91,9 @@ void scoremgr_add_new_record(const struct map* const map,
 	score_record_buffer_push(&s_scores, &record);
 	qsort(s_scores.mem, s_scores.size, sizeof(struct score_record),
 		&score_record_comparor);
+	const long long span = trace_begin();
 	FILE* fp = fopen("highscores.bin", "wb");
 	fwrite(s_scores.mem, sizeof(struct score_record), s_scores.size, fp);
 	fclose(fp);
+	trace_end("highscore write", span);
 }
\ No newline at end of file
@@ -0,0 +1,1696 @@
+/// @file solver.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Finding shortest solutions of maps.
+///
+/// Iterative deepening A* over the positions of the atoms, moving them
+/// with the same bitboard slides the game uses. Atoms with the same id
+/// look the same and may swap places, so a position is hashed by which
+/// ids are where, with Zobrist keys.
+///
+/// The heuristic is the one of Hüffner et al., "Finding Optimal
+/// Solutions to Atomix": with walls only, an atom can stop anywhere in a
+/// slide, so the moves it needs to reach a cell in this relaxed game are
+/// a lower bound. For every placement of the molecule, the cost is the
+/// cheapest assignment of distinct atoms with the right id to its cells,
+/// and the heuristic is the cheapest placement. Placements too expensive
+/// for the moves left are dropped for the whole subtree, so a position
+/// where no atoms are left to fill the cells is dropped at once.
+///
+/// A transposition table remembers positions proven to have no solution
+/// within some number of moves, across iterations.
+///
+/// Before the iterations, and between them while it costs less than they
+/// do, a perimeter around the goals is grown by searching backwards from
+/// them, one move further each time. Positions in it have their exact
+/// distance to the goal, and the path to it. A position not in it needs
+/// more moves than it covers, so it is dropped when fewer are left. Once
+/// it stops growing, it has every position that can reach a goal at all.
+///
+/// With more than one thread in the thread pool, every iteration is split
+/// at a shallow depth into subtrees, searched by all threads at once. Each
+/// thread has a deque of subtrees, takes from its front and steals from
+/// the back of the others when it runs out, without locks. They share the
+/// transposition table, updated with compare and swap. The next iteration
+/// only starts when every subtree of this one is done, so the first
+/// solution found is still a shortest one. The perimeter grows on every
+/// thread too, each expanding part of a layer.
+
+#include "pch.h"
+
+#include <limits.h>
+
+#include "globals.h"
+#include "solver.h"
+#include "atomics.h"
+#include "growable_buffer2.h"
+#include "molecule.h"
+#include "telemetry.h"
+#include "thread.h"
+#include "thread_pool.h"
+
+/// @addtogroup solver
+/// @{
+
+enum
+{
+	/// Cells of the arena, positions are x * 32 + y.
+	k_solver_cells = 32 * 32,
+
+	/// Most atoms in a map.
+	k_solver_max_atoms = 128,
+
+	/// Most moves searched for.
+	k_solver_max_depth = 200,
+
+	/// Relaxed distance of unreachable cells.
+	k_solver_unreachable = 255,
+
+	/// Cost of placements out of reach.
+	k_solver_out_of_reach = 0xFFFF,
+
+	/// Count of transposition table entries as a power of two.
+	k_solver_table_bits = 23,
+
+	/// Nodes expanded between checking the time limit.
+	k_solver_check_interval = 4096,
+
+	/// Most threads searching at once.
+	k_solver_max_threads = 64,
+
+	/// Deepest an iteration is split at.
+	k_solver_max_split = 16,
+
+	/// Subtrees an iteration is split into at least, for every thread.
+	k_solver_items_per_thread = 32,
+
+	/// Most memory the perimeter uses, roughly.
+	k_solver_perimeter_bytes = 1 << 28,
+
+	/// Positions the perimeter grows to before searching at all.
+	k_solver_perimeter_start = 1 << 16,
+
+	/// Positions of a layer of the perimeter expanded at once.
+	k_solver_growth_batch = 1 << 16,
+
+	/// Parts a batch is split into, for the threads.
+	k_solver_growth_parts = 64
+};
+
+/// Atoms with the same id, and the molecule cells wanting them.
+struct solver_group
+{
+	/// Index of the first atom.
+	int first_atom;
+
+	/// Count of atoms.
+	int atom_count;
+
+	/// Index of the first molecule cell.
+	int first_cell;
+
+	/// Count of molecule cells.
+	int cell_count;
+};
+
+/// A placement of the molecule still possible, with its cost.
+struct solver_placement
+{
+	/// Index of the placement.
+	uint16_t index;
+
+	/// Sum of the relaxed distances of the closest atoms.
+	uint16_t cost;
+};
+
+/// A move made during the search.
+struct solver_step
+{
+	/// Index of the atom moved.
+	int atom;
+
+	/// Position it moved from.
+	int from;
+
+	/// Position it moved to.
+	int to;
+
+	/// Direction it moved in.
+	enum direction direction;
+};
+
+/// A subtree of an iteration, the moves leading to it.
+struct solver_item
+{
+	/// Index of the atom moved by every move.
+	uint8_t atoms[k_solver_max_split];
+
+	/// Direction of every move.
+	uint8_t directions[k_solver_max_split];
+};
+
+DEFINE_GROWABLE_BUFFER(struct solver_item, solver_item_buffer)
+DEFINE_GROWABLE_BUFFER(uint16_t, solver_position_buffer)
+DEFINE_GROWABLE_BUFFER(uint64_t, solver_hash_buffer)
+
+struct solver_split;
+
+/// A set of positions.
+struct solver_set
+{
+	/// Atom positions of every position, ordered by group and by position
+	/// within a group.
+	struct solver_position_buffer atoms;
+
+	/// Hash of every position.
+	struct solver_hash_buffer hashes;
+
+	/// Hash table of the positions, indices plus one, 0 if empty.
+	int32_t* slots;
+
+	/// Count of slots as a power of two.
+	int slot_bits;
+};
+
+/// A position near the goal.
+struct solver_near
+{
+	/// Index of the position the move leads to, -1 for a goal.
+	int32_t next;
+
+	/// Position of the atom to move.
+	uint16_t from;
+
+	/// Direction to move it in.
+	uint8_t direction;
+
+	/// Moves needed to reach a goal.
+	uint8_t distance;
+};
+
+DEFINE_GROWABLE_BUFFER(struct solver_near, solver_near_buffer)
+
+/// Every position within some moves of a goal, found by searching
+/// backwards from the goals.
+struct solver_perimeter
+{
+	/// The positions.
+	struct solver_set set;
+
+	/// The move leading towards a goal from every position.
+	struct solver_near_buffer near;
+
+	/// Every position needing at most this many moves is in the set, -1
+	/// if none are.
+	int depth;
+
+	/// Index of the first position needing exactly depth moves.
+	int layer;
+
+	/// Most positions to keep.
+	int max_size;
+
+	/// Set when it can not grow any more.
+	bool full;
+};
+
+/// Positions found by one part of growing a perimeter.
+struct solver_growth_part
+{
+	/// Index of the first position of the perimeter to expand.
+	int first;
+
+	/// Index past the last one.
+	int last;
+
+	/// Hash of every position found.
+	struct solver_hash_buffer hashes;
+
+	/// Atom positions of every position found, sorted within every group.
+	struct solver_position_buffer atoms;
+
+	/// The move leading back into the perimeter from every position found.
+	struct solver_near_buffer near;
+};
+
+struct solver;
+
+/// A batch of a perimeter growing by a layer, split between threads.
+struct solver_growth
+{
+	/// The search.
+	const struct solver* s;
+
+	/// The perimeter, only read while the parts are searched.
+	const struct solver_perimeter* p;
+
+	/// The parts.
+	struct solver_growth_part parts[k_solver_growth_parts];
+};
+
+/// A search.
+struct solver
+{
+	/// Occupied cells, walls and atoms.
+	struct bitboard board;
+
+	/// Occupied cells, walls only.
+	struct bitboard walls;
+
+	/// Position of every atom, ordered by group.
+	uint16_t atoms[k_solver_max_atoms];
+
+	/// Group of every atom.
+	uint8_t atom_group[k_solver_max_atoms];
+
+	/// Count of atoms.
+	int atom_count;
+
+	/// The groups.
+	struct solver_group groups[k_solver_max_atoms];
+
+	/// Count of groups.
+	int group_count;
+
+	/// Count of molecule cells.
+	int cell_count;
+
+	/// Count of placements of the molecule.
+	int placement_count;
+
+	/// Target position of every molecule cell in every placement, ordered
+	/// by group.
+	uint16_t* targets;
+
+	/// Relaxed distance between every two positions.
+	uint8_t* distances;
+
+	/// Zobrist keys of every group on every position.
+	uint64_t (*keys)[k_solver_cells];
+
+	/// Hash of the current position.
+	uint64_t hash;
+
+	/// Transposition table, the hash with its low byte replaced by the
+	/// count of moves the position surely needs more than.
+	volatile uint64_t* table;
+
+	/// Placements still possible at every depth.
+	struct solver_placement* placements[k_solver_max_depth + 1];
+
+	/// Placement costs without the contribution of a moved group, at
+	/// every depth.
+	uint16_t* partial[k_solver_max_depth];
+
+	/// Moves leading to the current position.
+	struct solver_move path[k_solver_max_depth];
+
+	/// The same moves with the atoms and positions.
+	struct solver_step steps[k_solver_max_depth];
+
+	/// Positions near the goal, shared by every thread.
+	const struct solver_perimeter* perimeter;
+
+	/// Count of moves in the solution found.
+	int solution_length;
+
+	/// Count of positions expanded.
+	long long nodes;
+
+	/// Time to give up at, 0 for never.
+	long long deadline;
+
+	/// Set when the search gave up, or another thread found a solution.
+	bool stopped;
+
+	/// Depth the iteration is split at, 0 if it is not.
+	int split_depth;
+
+	/// Subtrees at the split depth are collected here instead of being
+	/// searched, if not NULL.
+	struct solver_item_buffer* frontier;
+
+	/// The split iteration this thread works on, NULL if not split.
+	struct solver_split* split;
+};
+
+/// Subtrees of one thread, taken from the front by the thread and stolen
+/// from the back by the others.
+///
+/// Subtrees are only dealt before the threads start, so the ends are
+/// only ever moved towards each other, both at once with compare and
+/// swap.
+struct solver_deque
+{
+	/// Index of the first item left in the low half, index past the last
+	/// one in the high half.
+	volatile uint64_t range;
+
+	/// Indices of the items.
+	int* items;
+};
+
+/// An iteration split between threads.
+struct solver_split
+{
+	/// Search of every thread.
+	struct solver* workers[k_solver_max_threads];
+
+	/// Subtrees of every thread.
+	struct solver_deque deques[k_solver_max_threads];
+
+	/// Count of threads.
+	int worker_count;
+
+	/// Occupied cells of the starting position.
+	struct bitboard root_board;
+
+	/// Position of every atom in the starting position.
+	uint16_t root_atoms[k_solver_max_atoms];
+
+	/// Hash of the starting position.
+	uint64_t root_hash;
+
+	/// The subtrees.
+	struct solver_item_buffer items;
+
+	/// Depth of the subtrees.
+	int depth;
+
+	/// Most moves allowed.
+	int bound;
+
+	/// Set to stop every thread, when a solution is found or the time
+	/// ran out.
+	volatile int32_t stop;
+
+	/// Protects found, length and path.
+	struct mutex lock;
+
+	/// Set when a solution was found.
+	bool found;
+
+	/// Count of moves in the solution found first.
+	int length;
+
+	/// The solution found first.
+	struct solver_move path[k_solver_max_depth];
+};
+
+/// Generate the next pseudo random number of a sequence.
+///
+/// @param[in,out] state State of the sequence.
+/// @return The number.
+static uint64_t splitmix64(uint64_t* state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/// Relaxed distance between two positions.
+///
+/// @param[in] s The search.
+/// @param[in] from A position.
+/// @param[in] to Another position.
+/// @return Moves needed with only the walls in the way.
+static inline int distance(const struct solver* s, int from, int to)
+{
+	return s->distances[from * k_solver_cells + to];
+}
+
+/// Fill the relaxed distances from a position.
+///
+/// @param[in,out] s The search.
+/// @param[in] walls Bitboard of the walls.
+/// @param[in] from The position.
+static void fill_distances(struct solver* s, const struct bitboard* walls,
+	int from)
+{
+	uint8_t* row = &s->distances[from * k_solver_cells];
+	uint16_t queue[k_solver_cells];
+	int head = 0;
+	int tail = 0;
+
+	row[from] = 0;
+	queue[tail++] = (uint16_t)from;
+	while (head < tail)
+	{
+		const int cell = queue[head++];
+		const int x = cell >> 5;
+		const int y = cell & 31;
+
+		// Every cell of a slide is one move away
+		for (int dir = Direction_Left; dir <= Direction_Down; ++dir)
+		{
+			int stop_x;
+			int stop_y;
+			bitboard_slide(walls, x, y, (enum direction)dir, &stop_x,
+				&stop_y);
+			for (int i = MIN(x, stop_x); i <= MAX(x, stop_x); ++i)
+				for (int j = MIN(y, stop_y); j <= MAX(y, stop_y); ++j)
+					if (row[i << 5 | j] == k_solver_unreachable)
+					{
+						row[i << 5 | j] = (uint8_t)(row[cell] + 1);
+						queue[tail++] = (uint16_t)(i << 5 | j);
+					}
+		}
+	}
+}
+
+/// Cost of the cells of a group in a placement.
+///
+/// Every atom can only fill one cell, so this is the cheapest assignment
+/// of distinct atoms to the cells, found with the Hungarian method.
+///
+/// @param[in] s The search.
+/// @param[in] group Index of the group.
+/// @param[in] placement Index of the placement.
+/// @return Sum of the distances of the assigned atoms to the cells.
+static int group_cost(const struct solver* s, int group, int placement)
+{
+	const struct solver_group* g = &s->groups[group];
+	const uint16_t* targets =
+		&s->targets[placement * s->cell_count + g->first_cell];
+	const uint16_t* atoms = &s->atoms[g->first_atom];
+	const int rows = g->cell_count;
+	const int cols = g->atom_count;
+
+	if (rows == 1)
+	{
+		int best = k_solver_unreachable;
+		for (int j = 0; j < cols; ++j)
+			best = MIN(best, distance(s, targets[0], atoms[j]));
+		return best;
+	}
+
+	// Potentials of the rows and columns, and the row assigned to every
+	// column, all counted from 1 with column 0 as the one being added
+	int u[k_solver_max_atoms + 1];
+	int v[k_solver_max_atoms + 1];
+	int assigned[k_solver_max_atoms + 1];
+	int way[k_solver_max_atoms + 1];
+	int slack[k_solver_max_atoms + 1];
+	bool used[k_solver_max_atoms + 1];
+	for (int j = 0; j <= cols; ++j)
+	{
+		v[j] = 0;
+		assigned[j] = 0;
+	}
+
+	for (int i = 1; i <= rows; ++i)
+	{
+		u[i] = 0;
+		assigned[0] = i;
+		int col = 0;
+		for (int j = 0; j <= cols; ++j)
+		{
+			slack[j] = INT_MAX;
+			used[j] = false;
+		}
+
+		// Grow alternating paths until an unassigned column is reached
+		do
+		{
+			used[col] = true;
+			const int row = assigned[col];
+			int delta = INT_MAX;
+			int next = 0;
+			for (int j = 1; j <= cols; ++j)
+			{
+				if (used[j])
+					continue;
+				const int cost = distance(s, targets[row - 1], atoms[j - 1])
+					- u[row] - v[j];
+				if (cost < slack[j])
+				{
+					slack[j] = cost;
+					way[j] = col;
+				}
+				if (slack[j] < delta)
+				{
+					delta = slack[j];
+					next = j;
+				}
+			}
+			for (int j = 0; j <= cols; ++j)
+				if (used[j])
+				{
+					u[assigned[j]] += delta;
+					v[j] -= delta;
+				}
+				else
+					slack[j] -= delta;
+			col = next;
+		} while (assigned[col]);
+
+		// Flip the path
+		do
+		{
+			const int prev = way[col];
+			assigned[col] = assigned[prev];
+			col = prev;
+		} while (col);
+	}
+	return -v[0];
+}
+
+/// Check if a cell is on a slide, not counting where it started.
+///
+/// @param[in] from Position the slide started at.
+/// @param[in] to Position the slide stopped at.
+/// @param[in] cell The position to check.
+/// @return True if the slide went through the cell.
+static bool slide_covers(int from, int to, int cell)
+{
+	const int from_x = from >> 5;
+	const int from_y = from & 31;
+	const int to_x = to >> 5;
+	const int to_y = to & 31;
+	const int x = cell >> 5;
+	const int y = cell & 31;
+	if (cell == from)
+		return false;
+	if (from_x == to_x)
+		return x == from_x && y >= MIN(from_y, to_y) && y <= MAX(from_y, to_y);
+	return y == from_y && x >= MIN(from_x, to_x) && x <= MAX(from_x, to_x);
+}
+
+/// Get the cell that stopped a slide.
+///
+/// @param[in] to Position the slide stopped at.
+/// @param[in] dir Direction of the slide.
+/// @return Position of the next cell, -1 if it was the edge.
+static int slide_blocker(int to, enum direction dir)
+{
+	const int x = to >> 5;
+	const int y = to & 31;
+	switch (dir)
+	{
+	case Direction_Left:	return x > 0 ? to - 32 : -1;
+	case Direction_Right:	return x < 31 ? to + 32 : -1;
+	case Direction_Up:		return y > 0 ? to - 1 : -1;
+	case Direction_Down:	return y < 31 ? to + 1 : -1;
+	}
+	return -1;
+}
+
+/// Check if two moves of different atoms give the same in either order.
+///
+/// Conservative, only checks that neither atom is in the way of or
+/// stopped by the other.
+///
+/// @param[in] first The move made first.
+/// @param[in] second The move made second.
+/// @return True if the moves can be swapped.
+static bool moves_commute(const struct solver_step* first,
+	const struct solver_step* second)
+{
+	return !slide_covers(second->from, second->to, first->from)
+		&& slide_blocker(second->to, second->direction) != first->to
+		&& !slide_covers(first->from, first->to, second->to)
+		&& slide_blocker(first->to, first->direction) != second->from;
+}
+
+/// Get the bucket of a position in the transposition table.
+///
+/// A bucket is two entries, the first keeps the position proven to need
+/// the most moves, the second the one stored last.
+///
+/// @param[in] s The search.
+/// @param[in] hash Hash of the position.
+/// @return The first entry of the bucket.
+static volatile uint64_t* table_bucket(const struct solver* s, uint64_t hash)
+{
+	return &s->table[hash & ((1u << k_solver_table_bits) - 2)];
+}
+
+/// Look up a position in the transposition table.
+///
+/// @param[in] s The search.
+/// @param[in] hash Hash of the position.
+/// @return Moves the position surely needs more than, 0 if unknown.
+static int table_lookup(const struct solver* s, uint64_t hash)
+{
+	volatile uint64_t* bucket = table_bucket(s, hash);
+	for (int i = 0; i < 2; ++i)
+	{
+		const uint64_t entry = atomic_load_u64(&bucket[i]);
+		if (!((entry ^ hash) >> 8))
+			return (int)(entry & 0xFF);
+	}
+	return 0;
+}
+
+/// Remember that a position has no solution within some moves.
+///
+/// Other threads may store to the same bucket at once, a larger count for
+/// the same position is kept.
+///
+/// @param[in,out] s The search.
+/// @param[in] hash Hash of the position.
+/// @param[in] moves Moves the position surely needs more than.
+static void table_store(struct solver* s, uint64_t hash, int moves)
+{
+	volatile uint64_t* bucket = table_bucket(s, hash);
+	const uint64_t entry =
+		(hash & ~(uint64_t)0xFF) | (uint64_t)MIN(moves, 0xFF);
+	for (;;)
+	{
+		const uint64_t first = atomic_load_u64(&bucket[0]);
+		const uint64_t second = atomic_load_u64(&bucket[1]);
+		volatile uint64_t* slot;
+		uint64_t old;
+		if (!((first ^ hash) >> 8) || (((second ^ hash) >> 8)
+			&& (first & 0xFF) <= (entry & 0xFF)))
+		{
+			slot = &bucket[0];
+			old = first;
+		}
+		else
+		{
+			slot = &bucket[1];
+			old = second;
+		}
+
+		if (!((old ^ hash) >> 8) && (old & 0xFF) >= (entry & 0xFF))
+			return;
+		if (atomic_cas_u64(slot, old, entry))
+			return;
+	}
+}
+
+/// Check if the search should stop.
+///
+/// @param[in,out] s The search.
+static void check_stop(struct solver* s)
+{
+	if (s->deadline && telemetry_now() > s->deadline)
+	{
+		s->stopped = true;
+		if (s->split)
+			atomic_store_i32(&s->split->stop, 1);
+	}
+	if (s->split && atomic_load_i32(&s->split->stop))
+		s->stopped = true;
+}
+
+/// Order the atoms of every group by position.
+///
+/// Atoms of a group look the same, so this gives every position one way
+/// to be written.
+///
+/// @param[in] s The search.
+/// @param[in] atoms Position of every atom, ordered by group.
+/// @param[out] sorted The same, ordered by position within every group.
+static void sort_groups(const struct solver* s, const uint16_t* atoms,
+	uint16_t* sorted)
+{
+	memcpy(sorted, atoms, sizeof(uint16_t) * s->atom_count);
+	for (int i = 0; i < s->group_count; ++i)
+	{
+		const struct solver_group* g = &s->groups[i];
+		for (int j = g->first_atom + 1; j < g->first_atom + g->atom_count; ++j)
+		{
+			const uint16_t atom = sorted[j];
+			int k = j;
+			for (; k > g->first_atom && sorted[k - 1] > atom; --k)
+				sorted[k] = sorted[k - 1];
+			sorted[k] = atom;
+		}
+	}
+}
+
+/// Find a position in a set.
+///
+/// @param[in] s The search.
+/// @param[in] set The set.
+/// @param[in] hash Hash of the position.
+/// @param[in] atoms Atom positions, sorted within every group.
+/// @return The slot holding it, or the empty slot it goes to.
+static int32_t* set_find(const struct solver* s, const struct solver_set* set,
+	uint64_t hash, const uint16_t* atoms)
+{
+	const size_t size = sizeof(uint16_t) * s->atom_count;
+	const uint32_t mask = (1u << set->slot_bits) - 1;
+	for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask)
+	{
+		const int32_t index = set->slots[i] - 1;
+		if (index < 0)
+			return &set->slots[i];
+		if (set->hashes.mem[index] == hash && !memcmp(atoms,
+			&set->atoms.mem[(size_t)index * s->atom_count], size))
+			return &set->slots[i];
+	}
+}
+
+/// Add a position to a set.
+///
+/// @param[in] s The search.
+/// @param[in,out] set The set.
+/// @param[in] hash Hash of the position.
+/// @param[in] atoms Atom positions, sorted within every group.
+/// @param[in,out] slot Empty slot from set_find().
+static void set_add(const struct solver* s, struct solver_set* set,
+	uint64_t hash, const uint16_t* atoms, int32_t* slot)
+{
+	const int index = solver_hash_buffer_push(&set->hashes, &hash);
+	const int first = solver_position_buffer_grow(&set->atoms, s->atom_count);
+	memcpy(&set->atoms.mem[first], atoms, sizeof(uint16_t) * s->atom_count);
+	*slot = index + 1;
+
+	// Keep the table at most half full
+	if (set->hashes.size * 2 <= 1 << set->slot_bits)
+		return;
+	free(set->slots);
+	++set->slot_bits;
+	set->slots = (int32_t*)calloc((size_t)1 << set->slot_bits,
+		sizeof(int32_t));
+	assert(set->slots);
+	for (int i = 0; i < set->hashes.size; ++i)
+		*set_find(s, set, set->hashes.mem[i],
+			&set->atoms.mem[(size_t)i * s->atom_count]) = i + 1;
+}
+
+/// Set up the perimeter of a search with the goals.
+///
+/// The goals are only known when every atom has a cell to go to,
+/// otherwise the perimeter stays empty.
+///
+/// @param[in] s The search, set up for the map.
+/// @param[out] p The perimeter.
+static void perimeter_init(const struct solver* s, struct solver_perimeter* p)
+{
+	solver_position_buffer_init(&p->set.atoms);
+	solver_hash_buffer_init(&p->set.hashes);
+	solver_near_buffer_init(&p->near);
+	p->set.slot_bits = 16;
+	p->set.slots = (int32_t*)calloc((size_t)1 << p->set.slot_bits,
+		sizeof(int32_t));
+	assert(p->set.slots);
+	p->depth = -1;
+	p->layer = 0;
+	p->max_size = (int)(k_solver_perimeter_bytes / (sizeof(uint16_t)
+		* s->atom_count + sizeof(uint64_t) + sizeof(struct solver_near)
+		+ sizeof(int32_t) * 4));
+	p->full = true;
+
+	for (int i = 0; i < s->group_count; ++i)
+		if (s->groups[i].atom_count != s->groups[i].cell_count)
+			return;
+
+	for (int i = 0; i < s->placement_count; ++i)
+	{
+		uint16_t atoms[k_solver_max_atoms];
+		uint16_t sorted[k_solver_max_atoms];
+		uint64_t hash = 0;
+		for (int j = 0; j < s->group_count; ++j)
+		{
+			const struct solver_group* g = &s->groups[j];
+			for (int k = 0; k < g->atom_count; ++k)
+			{
+				const int target =
+					s->targets[i * s->cell_count + g->first_cell + k];
+				atoms[g->first_atom + k] = (uint16_t)target;
+				hash ^= s->keys[j][target];
+			}
+		}
+		sort_groups(s, atoms, sorted);
+
+		int32_t* slot = set_find(s, &p->set, hash, sorted);
+		if (*slot)
+			continue;
+		const struct solver_near goal = { -1, 0, 0, 0 };
+		set_add(s, &p->set, hash, sorted, slot);
+		solver_near_buffer_push(&p->near, &goal);
+	}
+	p->depth = 0;
+	p->full = false;
+}
+
+/// Free a perimeter.
+///
+/// @param[in] p The perimeter.
+static void perimeter_free(struct solver_perimeter* p)
+{
+	free(p->set.slots);
+	solver_near_buffer_free(&p->near, NULL);
+	solver_hash_buffer_free(&p->set.hashes, NULL);
+	solver_position_buffer_free(&p->set.atoms, NULL);
+}
+
+/// Find the positions one move further from the goals than some of the
+/// perimeter, that are not in it yet.
+///
+/// Moves are followed backwards: an atom with something right next to it
+/// may have slid there from any free cell on the other side. Only reads
+/// the perimeter, so parts run on every thread at once.
+///
+/// @param[in] ctx The growth.
+/// @param[in] index Index of the part.
+static void perimeter_expand(void* ctx, int index)
+{
+	struct solver_growth* growth = (struct solver_growth*)ctx;
+	const struct solver* s = growth->s;
+	const struct solver_perimeter* p = growth->p;
+	struct solver_growth_part* part = &growth->parts[index];
+	part->hashes.size = 0;
+	part->atoms.size = 0;
+	part->near.size = 0;
+
+	for (int i = part->first; i < part->last; ++i)
+	{
+		uint16_t atoms[k_solver_max_atoms];
+		memcpy(atoms, &p->set.atoms.mem[(size_t)i * s->atom_count],
+			sizeof(uint16_t) * s->atom_count);
+		const uint64_t hash = p->set.hashes.mem[i];
+		struct bitboard board = s->walls;
+		for (int j = 0; j < s->atom_count; ++j)
+			bitboard_set(&board, atoms[j] >> 5, atoms[j] & 31);
+
+		for (int j = 0; j < s->atom_count; ++j)
+		{
+			const int group = s->atom_group[j];
+			const int to = atoms[j];
+			for (int dir = Direction_Left; dir <= Direction_Down; ++dir)
+			{
+				const int blocker = slide_blocker(to, (enum direction)dir);
+				if (blocker >= 0
+					&& !bitboard_get(&board, blocker >> 5, blocker & 31))
+					continue;
+
+				const enum direction back = (enum direction)(dir ^ 1);
+				for (int from = slide_blocker(to, back); from >= 0
+					&& !bitboard_get(&board, from >> 5, from & 31);
+					from = slide_blocker(from, back))
+				{
+					uint16_t sorted[k_solver_max_atoms];
+					atoms[j] = (uint16_t)from;
+					sort_groups(s, atoms, sorted);
+					atoms[j] = (uint16_t)to;
+
+					const uint64_t next_hash =
+						hash ^ s->keys[group][to] ^ s->keys[group][from];
+					if (*set_find(s, &p->set, next_hash, sorted))
+						continue;
+
+					const struct solver_near near = { i, (uint16_t)from,
+						(uint8_t)dir, (uint8_t)(p->depth + 1) };
+					solver_hash_buffer_push(&part->hashes, &next_hash);
+					const int first = solver_position_buffer_grow(&part->atoms,
+						s->atom_count);
+					memcpy(&part->atoms.mem[first], sorted,
+						sizeof(uint16_t) * s->atom_count);
+					solver_near_buffer_push(&part->near, &near);
+				}
+			}
+		}
+	}
+}
+
+/// Add the positions one more move away from the goals to a perimeter.
+///
+/// The layer is expanded in batches, split into parts searched by every
+/// thread of the thread pool. The parts are added in order, so the
+/// perimeter is the same with any count of threads.
+///
+/// @param[in,out] s The search, stopped if the time runs out.
+/// @param[in,out] p The perimeter.
+static void perimeter_grow(struct solver* s, struct solver_perimeter* p)
+{
+	struct solver_growth growth;
+	growth.s = s;
+	growth.p = p;
+	for (int i = 0; i < k_solver_growth_parts; ++i)
+	{
+		solver_hash_buffer_init(&growth.parts[i].hashes);
+		solver_position_buffer_init(&growth.parts[i].atoms);
+		solver_near_buffer_init(&growth.parts[i].near);
+	}
+
+	const int end = p->set.hashes.size;
+	for (int first = p->layer; first < end && !p->full;
+		first += k_solver_growth_batch)
+	{
+		if (s->deadline && telemetry_now() > s->deadline)
+		{
+			s->stopped = true;
+			p->full = true;
+			break;
+		}
+
+		const int count = MIN(end - first, (int)k_solver_growth_batch);
+		for (int i = 0; i < k_solver_growth_parts; ++i)
+		{
+			growth.parts[i].first = first
+				+ (int)((long long)count * i / k_solver_growth_parts);
+			growth.parts[i].last = first
+				+ (int)((long long)count * (i + 1) / k_solver_growth_parts);
+		}
+		thread_pool_run(&perimeter_expand, &growth, k_solver_growth_parts);
+
+		// Parts may have found the same positions
+		for (int i = 0; i < k_solver_growth_parts && !p->full; ++i)
+		{
+			const struct solver_growth_part* part = &growth.parts[i];
+			for (int j = 0; j < part->hashes.size; ++j)
+			{
+				const uint16_t* atoms =
+					&part->atoms.mem[(size_t)j * s->atom_count];
+				int32_t* slot =
+					set_find(s, &p->set, part->hashes.mem[j], atoms);
+				if (*slot)
+					continue;
+				if (p->set.hashes.size >= p->max_size)
+				{
+					p->full = true;
+					break;
+				}
+				set_add(s, &p->set, part->hashes.mem[j], atoms, slot);
+				solver_near_buffer_push(&p->near, &part->near.mem[j]);
+			}
+		}
+	}
+
+	for (int i = 0; i < k_solver_growth_parts; ++i)
+	{
+		solver_near_buffer_free(&growth.parts[i].near, NULL);
+		solver_position_buffer_free(&growth.parts[i].atoms, NULL);
+		solver_hash_buffer_free(&growth.parts[i].hashes, NULL);
+	}
+	if (p->full)
+		return;
+
+	// Nothing new, every other position can not reach a goal at all
+	p->layer = end;
+	if (p->set.hashes.size == end)
+	{
+		p->depth = k_solver_max_depth;
+		p->full = true;
+	}
+	else
+		++p->depth;
+}
+
+/// Find the current position in the perimeter.
+///
+/// @param[in] s The search.
+/// @param[in] hash Hash of the position.
+/// @return Index of the position, -1 if not in the perimeter.
+static int perimeter_find(const struct solver* s, uint64_t hash)
+{
+	const struct solver_set* set = &s->perimeter->set;
+	const uint32_t mask = (1u << set->slot_bits) - 1;
+	uint16_t sorted[k_solver_max_atoms];
+	bool is_sorted = false;
+	for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask)
+	{
+		const int32_t index = set->slots[i] - 1;
+		if (index < 0)
+			return -1;
+		if (set->hashes.mem[index] != hash)
+			continue;
+
+		// Only sort when the hash matches, it rarely does
+		if (!is_sorted)
+		{
+			sort_groups(s, s->atoms, sorted);
+			is_sorted = true;
+		}
+		if (!memcmp(sorted, &set->atoms.mem[(size_t)index * s->atom_count],
+			sizeof(uint16_t) * s->atom_count))
+			return index;
+	}
+}
+
+/// Add the moves from a position of the perimeter to a goal to the path.
+///
+/// @param[in,out] s The search.
+/// @param[in] depth Moves made so far.
+/// @param[in] index Index of the position in the perimeter.
+/// @return Count of moves in the path.
+static int perimeter_path(struct solver* s, int depth, int index)
+{
+	for (; s->perimeter->near.mem[index].next >= 0;
+		index = s->perimeter->near.mem[index].next)
+	{
+		const struct solver_near* near = &s->perimeter->near.mem[index];
+		s->path[depth].x = (int8_t)(near->from >> 5);
+		s->path[depth].y = (int8_t)(near->from & 31);
+		s->path[depth].direction = (int8_t)near->direction;
+		++depth;
+	}
+	return depth;
+}
+
+/// Search for a solution within a bound.
+///
+/// Of two moves that can be swapped only the order moving the atom with
+/// the lower index first is searched. Atoms are tried in index order, so
+/// the position the skipped order leads to was already searched at the
+/// same depth, and the position can still be stored as searched. That
+/// does not hold where the iteration is split, the other order may be in
+/// a subtree of another thread, so nothing is stored there.
+///
+/// @param[in,out] s The search, with the placements of this depth.
+/// @param[in] depth Moves made so far.
+/// @param[in] bound Most moves allowed.
+/// @param[in] count Count of placements possible.
+/// @param[in] h Cost of the cheapest placement.
+/// @return True if found, the moves are in the path.
+static bool search(struct solver* s, int depth, int bound, int count, int h)
+{
+	if (h == 0)
+	{
+		s->solution_length = depth;
+		return true;
+	}
+
+	if (s->frontier && depth == s->split_depth)
+	{
+		const int index = solver_item_buffer_grow(s->frontier, 1);
+		struct solver_item* item = &s->frontier->mem[index];
+		assert(depth <= k_solver_max_split);
+		for (int i = 0; i < depth && i < k_solver_max_split; ++i)
+		{
+			item->atoms[i] = (uint8_t)s->steps[i].atom;
+			item->directions[i] = (uint8_t)s->steps[i].direction;
+		}
+		return false;
+	}
+
+	if (++s->nodes % k_solver_check_interval == 0)
+		check_stop(s);
+	if (s->stopped)
+		return false;
+
+	const struct solver_placement* placements = s->placements[depth];
+	struct solver_placement* next = s->placements[depth + 1];
+	uint16_t* partial = s->partial[depth];
+	const int left = bound - depth - 1;
+	const uint64_t hash = s->hash;
+	const struct solver_step* last = depth ? &s->steps[depth - 1] : NULL;
+	const struct solver_perimeter* perimeter = s->perimeter;
+
+	for (int i = 0; i < s->atom_count; ++i)
+	{
+		const int group = s->atom_group[i];
+		const int from = s->atoms[i];
+		const int x = from >> 5;
+		const int y = from & 31;
+		const bool has_cells = s->groups[group].cell_count != 0;
+
+		if (has_cells)
+			for (int j = 0; j < count; ++j)
+				partial[j] = (uint16_t)(placements[j].cost
+					- group_cost(s, group, placements[j].index));
+
+		for (int dir = Direction_Left; dir <= Direction_Down; ++dir)
+		{
+			int stop_x;
+			int stop_y;
+			bitboard_slide(&s->board, x, y, (enum direction)dir, &stop_x,
+				&stop_y);
+			if (stop_x == x && stop_y == y)
+				continue;
+
+			const int to = stop_x << 5 | stop_y;
+			struct solver_step* step = &s->steps[depth];
+			step->atom = i;
+			step->from = from;
+			step->to = to;
+			step->direction = (enum direction)dir;
+			if (last && i < last->atom && moves_commute(last, step))
+				continue;
+
+			const uint64_t next_hash =
+				hash ^ s->keys[group][from] ^ s->keys[group][to];
+			if (table_lookup(s, next_hash) > left)
+				continue;
+
+			// Keep the placements still in reach
+			s->atoms[i] = (uint16_t)to;
+			int next_count = 0;
+			int next_h = k_solver_out_of_reach;
+			for (int j = 0; j < count; ++j)
+			{
+				const int cost = has_cells
+					? partial[j] + group_cost(s, group, placements[j].index)
+					: placements[j].cost;
+				if (cost > left)
+					continue;
+				next[next_count].index = placements[j].index;
+				next[next_count].cost = (uint16_t)cost;
+				++next_count;
+				next_h = MIN(next_h, cost);
+			}
+
+			// Near the goal the perimeter knows the exact distance, further
+			// away a hit would be a solution shorter than the bound
+			int near = -1;
+			if (next_count && left <= perimeter->depth + 1)
+			{
+				near = perimeter_find(s, next_hash);
+				if (near >= 0 ? perimeter->near.mem[near].distance > left
+					: perimeter->depth >= left)
+					next_count = 0;
+			}
+
+			bool found = false;
+			if (next_count)
+			{
+				s->path[depth].x = (int8_t)x;
+				s->path[depth].y = (int8_t)y;
+				s->path[depth].direction = (int8_t)dir;
+				if (near >= 0)
+				{
+					s->solution_length = perimeter_path(s, depth + 1, near);
+					found = true;
+				}
+				else
+				{
+					bitboard_clear(&s->board, x, y);
+					bitboard_set(&s->board, stop_x, stop_y);
+					s->hash = next_hash;
+
+					found = search(s, depth + 1, bound, next_count, next_h);
+
+					s->hash = hash;
+					bitboard_clear(&s->board, stop_x, stop_y);
+					bitboard_set(&s->board, x, y);
+				}
+			}
+			s->atoms[i] = (uint16_t)from;
+
+			if (found)
+				return true;
+			if (s->stopped)
+				return false;
+		}
+	}
+
+	if (!s->frontier && (depth == 0 || depth != s->split_depth))
+		table_store(s, hash, bound - depth);
+	return false;
+}
+
+/// Collect the placements of the current position within some moves.
+///
+/// @param[in,out] s The search.
+/// @param[in] depth Moves made so far.
+/// @param[in] left Most moves left.
+/// @param[out] h Cost of the cheapest placement, of all of them.
+/// @return Count of placements within the moves left.
+static int first_placements(struct solver* s, int depth, int left, int* h)
+{
+	int count = 0;
+	*h = k_solver_out_of_reach;
+	for (int i = 0; i < s->placement_count; ++i)
+	{
+		int cost = 0;
+		for (int j = 0; j < s->group_count; ++j)
+			cost += group_cost(s, j, i);
+		*h = MIN(*h, cost);
+		if (cost > left)
+			continue;
+		s->placements[depth][count].index = (uint16_t)i;
+		s->placements[depth][count].cost = (uint16_t)cost;
+		++count;
+	}
+	return count;
+}
+
+/// Set up a search for a map.
+///
+/// @param[out] s The search.
+/// @param[in] map The map.
+/// @return True if the molecule can be placed anywhere.
+static bool solver_init(struct solver* s, const struct map* map)
+{
+	struct bitboard walls;
+	memset(&walls, 0, sizeof(walls));
+	bitboard_from_arena(&s->board, map->arena);
+
+	// Order the atoms and the molecule cells by id
+	struct molecule molecule;
+	molecule_init(&molecule, map->molecule);
+	struct molecule_cell cells[16 * 16];
+	s->atom_count = 0;
+	s->group_count = 0;
+	s->cell_count = 0;
+	for (int id = 1; id < 0x80; ++id)
+	{
+		if (id == Item_Wall)
+			continue;
+
+		struct solver_group* g = &s->groups[s->group_count];
+		g->first_atom = s->atom_count;
+		g->first_cell = s->cell_count;
+		for (int x = 0; x < 32; ++x)
+			for (int y = 0; y < 32; ++y)
+				if (map->arena[x][y] == id)
+				{
+					assert(s->atom_count < k_solver_max_atoms);
+					s->atom_group[s->atom_count] = (uint8_t)s->group_count;
+					s->atoms[s->atom_count++] = (uint16_t)(x << 5 | y);
+				}
+		for (int i = 0; i < molecule.cell_count; ++i)
+			if (molecule.cells[i].id == id)
+				cells[s->cell_count++] = molecule.cells[i];
+		g->atom_count = s->atom_count - g->first_atom;
+		g->cell_count = s->cell_count - g->first_cell;
+
+		if (g->atom_count < g->cell_count)
+			return false;
+		if (g->atom_count)
+			++s->group_count;
+	}
+
+	for (int x = 0; x < 32; ++x)
+		for (int y = 0; y < 32; ++y)
+			if (map->arena[x][y] == Item_Wall)
+				bitboard_set(&walls, x, y);
+	s->walls = walls;
+
+	// Only cells some atom can get to matter
+	memset(s->distances, k_solver_unreachable,
+		(size_t)k_solver_cells * k_solver_cells);
+	bool reachable[k_solver_cells] = { false };
+	for (int i = 0; i < s->atom_count; ++i)
+	{
+		const int from = s->atoms[i];
+		if (reachable[from])
+			continue;
+		fill_distances(s, &walls, from);
+		for (int j = 0; j < k_solver_cells; ++j)
+			if (distance(s, from, j) != k_solver_unreachable)
+				reachable[j] = true;
+	}
+	for (int i = 0; i < k_solver_cells; ++i)
+		if (reachable[i])
+			fill_distances(s, &walls, i);
+
+	s->placement_count = 0;
+	for (int x = 0; x < 32; ++x)
+		for (int y = 0; y < 32; ++y)
+		{
+			uint16_t* targets =
+				&s->targets[s->placement_count * s->cell_count];
+			bool possible = true;
+			for (int i = 0; i < s->cell_count && possible; ++i)
+			{
+				const int cx = x + cells[i].x;
+				const int cy = y + cells[i].y;
+				possible = cx < 32 && cy < 32 && reachable[cx << 5 | cy];
+				targets[i] = (uint16_t)(cx << 5 | cy);
+			}
+			if (possible)
+				++s->placement_count;
+		}
+
+	uint64_t seed = 0;
+	s->hash = 0;
+	for (int i = 0; i < s->group_count; ++i)
+		for (int j = 0; j < k_solver_cells; ++j)
+			s->keys[i][j] = splitmix64(&seed);
+	for (int i = 0; i < s->atom_count; ++i)
+		s->hash ^= s->keys[s->atom_group[i]][s->atoms[i]];
+
+	memset((void*)s->table, 0, sizeof(uint64_t) << k_solver_table_bits);
+	s->nodes = 0;
+	s->stopped = false;
+	return s->placement_count != 0;
+}
+
+/// Allocate the per depth buffers of a search.
+///
+/// @param[in,out] s The search.
+static void solver_alloc_depths(struct solver* s)
+{
+	for (int i = 0; i <= k_solver_max_depth; ++i)
+	{
+		s->placements[i] = (struct solver_placement*)malloc(
+			sizeof(struct solver_placement) * k_solver_cells);
+		assert(s->placements[i]);
+		if (i < k_solver_max_depth)
+		{
+			s->partial[i] = (uint16_t*)malloc(
+				sizeof(uint16_t) * k_solver_cells);
+			assert(s->partial[i]);
+		}
+	}
+}
+
+/// Free the per depth buffers of a search.
+///
+/// @param[in] s The search.
+static void solver_free_depths(struct solver* s)
+{
+	for (int i = 0; i <= k_solver_max_depth; ++i)
+	{
+		free(s->placements[i]);
+		if (i < k_solver_max_depth)
+			free(s->partial[i]);
+	}
+}
+
+/// Allocate a search.
+///
+/// @return The search.
+static struct solver* solver_alloc(void)
+{
+	struct solver* s = (struct solver*)calloc(1, sizeof(struct solver));
+	assert(s);
+	s->targets = (uint16_t*)malloc(
+		sizeof(uint16_t) * k_solver_cells * 16 * 16);
+	s->distances = (uint8_t*)malloc((size_t)k_solver_cells * k_solver_cells);
+	s->keys = (uint64_t(*)[k_solver_cells])malloc(
+		sizeof(*s->keys) * k_solver_max_atoms);
+	s->table = (uint64_t*)malloc(sizeof(uint64_t) << k_solver_table_bits);
+	assert(s->targets && s->distances && s->keys && s->table);
+	solver_alloc_depths(s);
+	return s;
+}
+
+/// Free a search.
+///
+/// @param[in] s The search.
+static void solver_free(struct solver* s)
+{
+	solver_free_depths(s);
+	free((void*)s->table);
+	free(s->keys);
+	free(s->distances);
+	free(s->targets);
+	free(s);
+}
+
+/// Make a move of the subtree a thread starts at.
+///
+/// @param[in,out] s The search.
+/// @param[in] depth Moves made so far.
+/// @param[in] atom Index of the atom to move.
+/// @param[in] dir Direction to move it in.
+static void make_move(struct solver* s, int depth, int atom,
+	enum direction dir)
+{
+	const int group = s->atom_group[atom];
+	const int from = s->atoms[atom];
+	int stop_x;
+	int stop_y;
+	bitboard_slide(&s->board, from >> 5, from & 31, dir, &stop_x, &stop_y);
+	const int to = stop_x << 5 | stop_y;
+
+	bitboard_clear(&s->board, from >> 5, from & 31);
+	bitboard_set(&s->board, stop_x, stop_y);
+	s->atoms[atom] = (uint16_t)to;
+	s->hash ^= s->keys[group][from] ^ s->keys[group][to];
+	s->path[depth].x = (int8_t)(from >> 5);
+	s->path[depth].y = (int8_t)(from & 31);
+	s->path[depth].direction = (int8_t)dir;
+	s->steps[depth].atom = atom;
+	s->steps[depth].from = from;
+	s->steps[depth].to = to;
+	s->steps[depth].direction = dir;
+}
+
+/// Take a subtree, from the own deque or stolen from another.
+///
+/// @param[in,out] split The split iteration.
+/// @param[in] index Index of the thread.
+/// @param[out] item Index of the subtree.
+/// @return True if there was one left.
+static bool take_item(struct solver_split* split, int index, int* item)
+{
+	for (int i = 0; i < split->worker_count; ++i)
+	{
+		struct solver_deque* deque =
+			&split->deques[(index + i) % split->worker_count];
+		for (;;)
+		{
+			const uint64_t range = atomic_load_u64(&deque->range);
+			const uint32_t head = (uint32_t)range;
+			const uint32_t tail = (uint32_t)(range >> 32);
+			if (head >= tail)
+				break;
+
+			// The own front, or the back of another
+			const uint64_t next = i == 0
+				? range + 1 : range - ((uint64_t)1 << 32);
+			if (atomic_cas_u64(&deque->range, range, next))
+			{
+				*item = deque->items[i == 0 ? head : tail - 1];
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/// Search subtrees of a split iteration until none are left.
+///
+/// @param[in] ctx The split iteration.
+/// @param[in] index Index of the thread.
+static void search_items(void* ctx, int index)
+{
+	struct solver_split* split = (struct solver_split*)ctx;
+	struct solver* s = split->workers[index];
+	int item;
+
+	while (!atomic_load_i32(&split->stop) && take_item(split, index, &item))
+	{
+		memcpy(&s->board, &split->root_board, sizeof(s->board));
+		memcpy(s->atoms, split->root_atoms, sizeof(s->atoms));
+		s->hash = split->root_hash;
+		const struct solver_item* moves = &split->items.mem[item];
+		for (int i = 0; i < split->depth; ++i)
+			make_move(s, i, moves->atoms[i],
+				(enum direction)moves->directions[i]);
+
+		int h;
+		const int count = first_placements(s, split->depth,
+			split->bound - split->depth, &h);
+		if (count && search(s, split->depth, split->bound, count, h))
+		{
+			mutex_lock(&split->lock);
+			if (!split->found)
+			{
+				split->found = true;
+				split->length = s->solution_length;
+				memcpy(split->path, s->path,
+					sizeof(*s->path) * s->solution_length);
+			}
+			mutex_unlock(&split->lock);
+			atomic_store_i32(&split->stop, 1);
+		}
+	}
+}
+
+/// Search one iteration on every thread of the thread pool.
+///
+/// @param[in,out] s The search, at the starting position.
+/// @param[in,out] split Threads of the search.
+/// @param[in] bound Most moves allowed.
+/// @return True if found, the moves are in the path of the search.
+static bool search_split(struct solver* s, struct solver_split* split,
+	int bound)
+{
+	// Split deeper until every thread has enough subtrees
+	const int wanted = k_solver_items_per_thread * split->worker_count;
+	for (int depth = 1;; ++depth)
+	{
+		int h;
+		split->items.size = 0;
+		s->split_depth = depth;
+		s->frontier = &split->items;
+		const int count = first_placements(s, 0, bound, &h);
+		const bool found = count && search(s, 0, bound, count, h);
+		s->frontier = NULL;
+		s->split_depth = 0;
+		if (found || s->stopped)
+			return found;
+
+		split->depth = depth;
+		if (split->items.size >= wanted || depth + 1 >= bound
+			|| depth == k_solver_max_split)
+			break;
+	}
+
+	// Deal the subtrees to the threads in turns
+	const int item_count = split->items.size;
+	for (int i = 0; i < split->worker_count; ++i)
+	{
+		struct solver_deque* deque = &split->deques[i];
+		deque->items = (int*)realloc(deque->items,
+			sizeof(int) * (item_count / split->worker_count + 1));
+		assert(deque->items);
+		uint32_t tail = 0;
+		for (int j = i; j < item_count; j += split->worker_count)
+			deque->items[tail++] = j;
+		deque->range = (uint64_t)tail << 32;
+
+		struct solver* worker = split->workers[i];
+		worker->split_depth = split->depth;
+		worker->stopped = false;
+	}
+
+	memcpy(&split->root_board, &s->board, sizeof(s->board));
+	memcpy(split->root_atoms, s->atoms, sizeof(s->atoms));
+	split->root_hash = s->hash;
+	split->bound = bound;
+	split->found = false;
+	split->stop = 0;
+	thread_pool_run(&search_items, split, split->worker_count);
+
+	for (int i = 0; i < split->worker_count; ++i)
+	{
+		s->nodes += split->workers[i]->nodes;
+		split->workers[i]->nodes = 0;
+	}
+	if (split->found)
+	{
+		s->solution_length = split->length;
+		memcpy(s->path, split->path, sizeof(*s->path) * split->length);
+	}
+	else if (split->stop)
+		s->stopped = true;
+	return split->found;
+}
+
+/// Set up the threads of a search.
+///
+/// @param[in] s The search, set up for the map.
+/// @param[in] count Count of threads.
+/// @return The threads.
+static struct solver_split* split_alloc(const struct solver* s, int count)
+{
+	struct solver_split* split =
+		(struct solver_split*)calloc(1, sizeof(struct solver_split));
+	assert(split);
+	split->worker_count = count;
+	solver_item_buffer_init(&split->items);
+	mutex_init(&split->lock);
+	for (int i = 0; i < count; ++i)
+	{
+		// Everything but the per depth buffers is shared or copied
+		struct solver* worker = (struct solver*)malloc(sizeof(*worker));
+		assert(worker);
+		memcpy(worker, s, sizeof(*worker));
+		solver_alloc_depths(worker);
+		worker->nodes = 0;
+		worker->split = split;
+		split->workers[i] = worker;
+	}
+	return split;
+}
+
+/// Free the threads of a search.
+///
+/// @param[in] split The threads.
+static void split_free(struct solver_split* split)
+{
+	for (int i = 0; i < split->worker_count; ++i)
+	{
+		solver_free_depths(split->workers[i]);
+		free(split->workers[i]);
+		free(split->deques[i].items);
+	}
+	mutex_destroy(&split->lock);
+	solver_item_buffer_free(&split->items, NULL);
+	free(split);
+}
+
+/// Find a shortest solution of a map.
+///
+/// Searches with increasing bounds until a solution is found, the bound
+/// exceeds max_moves, or the time runs out. Uses every thread of the
+/// thread pool.
+///
+/// @param[in] map The map.
+/// @param[in] max_moves Most moves to search for.
+/// @param[in] time_limit Nanoseconds to give up after, 0 for no limit.
+/// @param[out] moves The solution, room for max_moves moves.
+/// @param[out] stats Statistics of the search.
+/// @return Count of moves in the solution, -1 if not found.
+int solver_solve(const struct map* map, int max_moves, long long time_limit,
+	struct solver_move* moves, struct solver_stats* stats)
+{
+	const long long start = telemetry_now();
+	struct solver* s = solver_alloc();
+	CLAMP_IN_PLACE(max_moves, 0, (int)k_solver_max_depth);
+	s->deadline = time_limit ? start + time_limit : 0;
+
+	int result = -1;
+	int bound = 0;
+	if (solver_init(s, map))
+	{
+		struct solver_perimeter perimeter;
+		perimeter_init(s, &perimeter);
+		s->perimeter = &perimeter;
+
+		struct solver_split* split = NULL;
+		const int threads = MIN(thread_pool_size(), (int)k_solver_max_threads);
+		if (threads > 1)
+			split = split_alloc(s, threads);
+
+		int h;
+		first_placements(s, 0, 0, &h);
+		bound = MAX(h, 0);
+		for (; bound <= max_moves; ++bound)
+		{
+			// Grow the perimeter while it is smaller than the search was
+			while (!perimeter.full && !s->stopped && perimeter.set.hashes.size
+				<= MAX(s->nodes, (long long)k_solver_perimeter_start))
+				perimeter_grow(s, &perimeter);
+			if (s->stopped)
+				break;
+
+			// The start itself may be near the goal, otherwise it needs more
+			// moves than the perimeter covers
+			const int near = perimeter_find(s, s->hash);
+			bool found;
+			if (near >= 0)
+			{
+				bound = perimeter.near.mem[near].distance;
+				found = bound <= max_moves;
+				if (found)
+					s->solution_length = perimeter_path(s, 0, near);
+			}
+			else
+			{
+				bound = MAX(bound, perimeter.depth + 1);
+				if (bound > max_moves)
+					break;
+				if (split)
+					found = search_split(s, split, bound);
+				else
+				{
+					const int count = first_placements(s, 0, bound, &h);
+					found = count && search(s, 0, bound, count, h);
+				}
+			}
+
+			if (found)
+			{
+				result = s->solution_length;
+				memcpy(moves, s->path, sizeof(*moves) * result);
+				break;
+			}
+			if (s->stopped || near >= 0)
+				break;
+		}
+
+		if (split)
+			split_free(split);
+		perimeter_free(&perimeter);
+	}
+
+	stats->nodes = s->nodes;
+	stats->nanoseconds = telemetry_now() - start;
+	stats->lower_bound = bound;
+	solver_free(s);
+	return result;
+}
+
+/// @}
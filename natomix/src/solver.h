@@ -0,0 +1,43 @@
+/// @file solver.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Finding shortest solutions of maps.
+
+#pragma once
+#include "map.h"
+#include "bitboard.h"
+
+/// @addtogroup solver
+/// @{
+
+/// A move of a solution.
+struct solver_move
+{
+	/// Column of the atom to move.
+	int8_t x;
+
+	/// Row of the atom to move.
+	int8_t y;
+
+	/// Direction to move it in.
+	int8_t direction;
+};
+
+/// Statistics of a search.
+struct solver_stats
+{
+	/// Count of positions expanded.
+	long long nodes;
+
+	/// Time the search took in nanoseconds.
+	long long nanoseconds;
+
+	/// Solutions shorter than this do not exist.
+	int lower_bound;
+};
+
+extern int solver_solve(const struct map* map, int max_moves,
+	long long time_limit, struct solver_move* moves,
+	struct solver_stats* stats);
+
+/// @}
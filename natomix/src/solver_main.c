@@ -0,0 +1,398 @@
+/// @file solver_main.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Command line solver for the map packs
+///
+/// Finds shortest solutions for the levels of a pack, checks them by
+/// playing them with the game's rules, and reports the search speed.
+/// Can also solve the same levels with 1, 2, 4 and so on threads, to see
+/// how the search scales.
+
+#include "pch.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+
+#include "globals.h"
+#include "map_manager.h"
+#include "molecule.h"
+#include "solver.h"
+#include "thread.h"
+#include "thread_pool.h"
+
+/// @addtogroup solver_main
+/// @{
+
+/// Nanoseconds in a second.
+static const long long k_nanoseconds = 1000000000LL;
+
+/// Command line options.
+struct options
+{
+	/// Directory holding the game data, or NULL for the current one.
+	const char* data_dir;
+
+	/// Name of the pack to solve, "all" for every pack.
+	const char* pack;
+
+	/// Level to solve, or -1 for all of them.
+	int level;
+
+	/// Moves every solution must have, or -1 for any.
+	int moves;
+
+	/// Seconds to give up on a level after, 0 for never.
+	double seconds;
+
+	/// Most moves to search for.
+	int max_moves;
+
+	/// Count of threads to search with, the most for scaling.
+	int threads;
+
+	/// Solve with every power of two threads up to threads.
+	bool scaling;
+};
+
+/// Result of solving a level.
+struct level_result
+{
+	/// Moves of the solution, -1 if not found.
+	int moves;
+
+	/// Time the search took in nanoseconds.
+	long long nanoseconds;
+};
+
+/// Results of solving a set of levels.
+struct run_results
+{
+	/// Count of levels tried.
+	int tried;
+
+	/// Count of levels solved.
+	int solved;
+
+	/// Count of positions expanded.
+	long long nodes;
+
+	/// Time the searches took in nanoseconds.
+	long long nanoseconds;
+
+	/// Set when a solution was not accepted by the game's rules, or did
+	/// not have the moves asked for.
+	bool invalid;
+};
+
+/// Print usage.
+///
+/// @param[in] name Program name.
+static void print_usage(const char* name)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --data DIR       directory holding the game data\n"
+		"  --pack NAME      pack to solve, original by default, all for all\n"
+		"  --level N        only solve level N, counted from 0\n"
+		"  --moves N        fail unless the solutions have N moves\n"
+		"  --seconds S      give up on a level after S seconds, 0 never\n"
+		"  --max-moves N    longest solution searched for\n"
+		"  --threads N      threads to search with, all cores by default\n"
+		"  --scaling        solve with 1, 2, 4, ... up to --threads threads\n",
+		name);
+}
+
+/// Parse the command line.
+///
+/// @param[in] argc Argument count.
+/// @param[in] argv Arguments.
+/// @param[out] opts Parsed options.
+/// @return True if succeeded.
+static bool parse_options(int argc, char** argv, struct options* opts)
+{
+	opts->data_dir = NULL;
+	opts->pack = "original";
+	opts->level = -1;
+	opts->moves = -1;
+	opts->seconds = 10.0;
+	opts->max_moves = 100;
+	opts->threads = thread_hardware_concurrency();
+	opts->scaling = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		if (!strcmp(arg, "--scaling"))
+		{
+			opts->scaling = true;
+			continue;
+		}
+
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (!value)
+			return false;
+		++i;
+
+		if (!strcmp(arg, "--data"))
+			opts->data_dir = value;
+		else if (!strcmp(arg, "--pack"))
+			opts->pack = value;
+		else if (!strcmp(arg, "--level"))
+			opts->level = atoi(value);
+		else if (!strcmp(arg, "--moves"))
+			opts->moves = atoi(value);
+		else if (!strcmp(arg, "--seconds"))
+			opts->seconds = atof(value);
+		else if (!strcmp(arg, "--max-moves"))
+			opts->max_moves = atoi(value);
+		else if (!strcmp(arg, "--threads"))
+			opts->threads = atoi(value);
+		else
+			return false;
+	}
+	return opts->threads > 0;
+}
+
+/// Play a solution with the game's rules.
+///
+/// @param[in] map The map.
+/// @param[in] moves The solution.
+/// @param[in] count Count of moves.
+/// @return True if every move moves an atom and the molecule is built.
+static bool check_solution(const struct map* map,
+	const struct solver_move* moves, int count)
+{
+	static struct map played;
+	played = *map;
+	struct bitboard board;
+	bitboard_from_arena(&board, played.arena);
+
+	for (int i = 0; i < count; ++i)
+	{
+		const int x = moves[i].x;
+		const int y = moves[i].y;
+		const char id = played.arena[x][y];
+		if (!id || id == Item_Wall)
+			return false;
+
+		int stop_x;
+		int stop_y;
+		bitboard_slide(&board, x, y, (enum direction)moves[i].direction,
+			&stop_x, &stop_y);
+		if (stop_x == x && stop_y == y)
+			return false;
+		played.arena[x][y] = 0;
+		bitboard_clear(&board, x, y);
+		played.arena[stop_x][stop_y] = id;
+		bitboard_set(&board, stop_x, stop_y);
+	}
+
+	struct molecule molecule;
+	molecule_init(&molecule, played.molecule);
+	return molecule_find(&molecule, played.arena);
+}
+
+/// Print a solution.
+///
+/// @param[in] moves The solution.
+/// @param[in] count Count of moves.
+static void print_solution(const struct solver_move* moves, int count)
+{
+	static const char k_directions[] = "LRUD";
+	printf("   ");
+	for (int i = 0; i < count; ++i)
+		printf(" %d,%d%c", moves[i].x, moves[i].y,
+			k_directions[moves[i].direction]);
+	printf("\n");
+}
+
+/// Solve the levels of some packs.
+///
+/// @param[in] opts Options.
+/// @param[in] packs Indices of the packs.
+/// @param[in] pack_count Count of packs.
+/// @param[in] verbose Print every level and its solution.
+/// @param[out] levels Result of every level.
+/// @param[out] results Results of all levels.
+static void solve_levels(const struct options* opts, const int* packs,
+	int pack_count, bool verbose, struct level_result* levels,
+	struct run_results* results)
+{
+	struct solver_move* moves = (struct solver_move*)malloc(
+		sizeof(struct solver_move) * MAX(opts->max_moves, 1));
+	assert(moves);
+	const long long time_limit = (long long)(opts->seconds * k_nanoseconds);
+	memset(results, 0, sizeof(*results));
+
+	for (int i = 0; i < pack_count; ++i)
+		for (int level = opts->level < 0 ? 0 : opts->level;; ++level)
+		{
+			const struct map* map = mapmgr_get_pack_level(packs[i], level);
+			if (!map || (opts->level >= 0 && level != opts->level))
+				break;
+
+			struct solver_stats stats;
+			const int count = solver_solve(map, opts->max_moves, time_limit,
+				moves, &stats);
+			const bool played = count < 0 || check_solution(map, moves, count);
+			const bool valid = played
+				&& (count < 0 || opts->moves < 0 || count == opts->moves);
+			levels[results->tried].moves = valid ? count : -1;
+			levels[results->tried].nanoseconds = stats.nanoseconds;
+			++results->tried;
+			results->solved += count >= 0 && valid;
+			results->invalid = results->invalid || !valid;
+			results->nodes += stats.nodes;
+			results->nanoseconds += stats.nanoseconds;
+			if (!verbose)
+				continue;
+
+			const double seconds = (double)stats.nanoseconds / k_nanoseconds;
+			const double rate = stats.nanoseconds
+				? (double)stats.nodes * k_nanoseconds / stats.nanoseconds
+				: 0.0;
+			if (count >= 0)
+			{
+				printf("%2d %-26s %3d moves %12lld nodes %9.3f s %11.0f "
+					"nodes/s%s\n", level, map->name, count, stats.nodes,
+					seconds, rate, !played ? " INVALID"
+						: !valid ? " UNEXPECTED LENGTH" : "");
+				print_solution(moves, count);
+			}
+			else
+				printf("%2d %-26s >=%d moves %12lld nodes %9.3f s %11.0f "
+					"nodes/s gave up\n", level, map->name, stats.lower_bound,
+					stats.nodes, seconds, rate);
+			fflush(stdout);
+		}
+
+	free(moves);
+}
+
+/// Print a summary of results.
+///
+/// @param[in] threads Count of threads searched with.
+/// @param[in] results The results.
+/// @param[in] speedup Speedup over one thread, 0 if not known.
+static void print_results(int threads, const struct run_results* results,
+	double speedup)
+{
+	printf("%3d threads: solved %d of %d levels in %.3f s, %lld nodes, "
+		"%.0f nodes/s", threads, results->solved, results->tried,
+		(double)results->nanoseconds / k_nanoseconds, results->nodes,
+		results->nanoseconds
+			? (double)results->nodes * k_nanoseconds / results->nanoseconds
+			: 0.0);
+	if (speedup)
+		printf(", %.2fx", speedup);
+	printf("\n");
+	fflush(stdout);
+}
+
+/// Application entry point.
+///
+/// @param[in] argc Argument count.
+/// @param[in] argv Arguments.
+/// @return 0 if every level was solved.
+int main(int argc, char** argv)
+{
+	struct options opts;
+	if (!parse_options(argc, argv, &opts))
+	{
+		print_usage(argv[0]);
+		return 2;
+	}
+
+	if (opts.data_dir && chdir(opts.data_dir) != 0)
+	{
+		perror(opts.data_dir);
+		return 1;
+	}
+
+	mapmgr_init();
+
+	char names[16][32];
+	const int name_count = mapmgr_get_pack_names(names, 16);
+	int packs[16];
+	int pack_count = 0;
+	int level_count = 0;
+	for (int i = 0; i < name_count; ++i)
+		if (!strcmp(opts.pack, "all") || !strcmp(names[i], opts.pack))
+		{
+			packs[pack_count++] = i;
+			for (int level = 0; mapmgr_get_pack_level(i, level); ++level)
+				++level_count;
+		}
+	if (pack_count == 0)
+	{
+		fprintf(stderr, "%s: no such pack\n", opts.pack);
+		return 1;
+	}
+
+	struct level_result* levels = (struct level_result*)malloc(
+		sizeof(struct level_result) * MAX(level_count, 1) * 2);
+	assert(levels);
+	struct level_result* base_levels = levels + MAX(level_count, 1);
+	struct run_results results;
+	bool ok;
+
+	if (!opts.scaling)
+	{
+		thread_pool_start(opts.threads);
+		solve_levels(&opts, packs, pack_count, true, levels, &results);
+		thread_pool_stop();
+		print_results(opts.threads, &results, 0.0);
+		ok = !results.invalid && results.solved == results.tried;
+	}
+	else
+	{
+		const int cores = thread_hardware_concurrency();
+		if (opts.threads > cores)
+			printf("only %d cores, threads past that share them\n", cores);
+
+		// Solutions must be as short with any count of threads. Levels
+		// given up on take the time limit with any count, so speedups only
+		// count the levels solved with one thread.
+		ok = true;
+		for (int threads = 1;; threads = MIN(threads * 2, opts.threads))
+		{
+			thread_pool_start(threads);
+			solve_levels(&opts, packs, pack_count, false,
+				threads == 1 ? base_levels : levels, &results);
+			thread_pool_stop();
+			if (threads == 1)
+				memcpy(levels, base_levels, sizeof(*levels) * results.tried);
+
+			long long base = 0;
+			long long time = 0;
+			for (int i = 0; i < results.tried; ++i)
+			{
+				if (base_levels[i].moves < 0)
+					continue;
+				base += base_levels[i].nanoseconds;
+				time += levels[i].nanoseconds;
+				if (levels[i].moves >= 0
+					&& levels[i].moves != base_levels[i].moves)
+				{
+					printf("level %d: %d moves with %d threads, %d with one\n",
+						i, levels[i].moves, threads, base_levels[i].moves);
+					ok = false;
+				}
+			}
+			print_results(threads, &results, time ? (double)base / time : 0.0);
+
+			ok = ok && !results.invalid;
+			if (threads == opts.threads)
+				break;
+		}
+	}
+
+	free(levels);
+	return ok ? 0 : 1;
+}
+
+/// @}
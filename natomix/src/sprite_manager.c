@@ -6,7 +6,7 @@
 #include "pch.h"
 
 #include "sprite_manager.h"
-#include "growable_buffer2.h"
+#include "trace.h"
 
 /// @addtogroup sprites
 /// @{
@@ -21,14 +21,19 @@ void sprite_manager_init(void)
 
 /// Loads one or more sprites from a file into the manager.
 ///
+/// Sprites never move once loaded, so the renderer may read them while
+/// new ones are being loaded.
+///
 /// @param[in] file Name of the file to load
 /// @param[in] count Count of sprites in the file
 /// @return First loaded sprite ID
 int sprite_manager_load_from_file(const char* file, const int count)
 {
+	const long long span = trace_begin();
 	const int new_sprites = sprite_buffer_grow(&s_sprites, (int)count);
 	sprite_load_from_file(file,
-		&s_sprites.mem[new_sprites], (int)count);
+		sprite_buffer_at(&s_sprites, new_sprites), (int)count);
+	trace_end("sprite_manager_load_from_file", span);
 	return new_sprites;
 }
 
@@ -42,20 +47,34 @@ int sprite_manager_load_from_file(const char* file, const int count)
 int sprite_manager_load_from_file_2d(const char* file, int x, int y)
 {
 	const int count = x * y;
+	const long long span = trace_begin();
 	const int new_sprites = sprite_buffer_grow(&s_sprites, (int)count);
 	sprite_load_from_file_2d(file,
-		&s_sprites.mem[new_sprites], x, y);
+		sprite_buffer_at(&s_sprites, new_sprites), x, y);
+	trace_end("sprite_manager_load_from_file_2d", span);
+	return new_sprites;
+}
+
+/// Adds sprites made at runtime to the manager.
+///
+/// @param[in] sprites The sprites to copy, already prepared for drawing.
+/// @param[in] count Count of sprites.
+/// @return First added sprite ID
+int sprite_manager_add(const struct sprite* sprites, int count)
+{
+	const int new_sprites = sprite_buffer_grow(&s_sprites, count);
+	memcpy(sprite_buffer_at(&s_sprites, new_sprites), sprites,
+		count * sizeof(struct sprite));
 	return new_sprites;
 }
 
 /// Returns the sprite associated to the given ID.
 ///
 /// @param[in] id The ID of the sprite.
-/// @return Pointer to the sprite struct.
-/// @warning The pointer may become invalid after loading new sprites.
+/// @return Pointer to the sprite struct, valid for the whole run.
 const struct sprite* sprite_manager_get_by_id(int id)
 {
-	return &s_sprites.mem[id];
+	return sprite_buffer_at(&s_sprites, id);
 }
 
 /// @}
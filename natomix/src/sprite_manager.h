@@ -5,35 +5,138 @@
 
 #pragma once
 #include "color.h"
+#include "blend.h"
 #include "globals.h"
-#include "growable_buffer2.h"
+#include "rect.h"
+#include "chunked_buffer.h"
 
 /// @addtogroup sprites
 /// @{
 
+/// How a sprite or a row of it covers what is below it.
+enum sprite_opacity
+{
+	/// Every pixel has zero alpha, drawing it changes nothing.
+	Opacity_Transparent,
+
+	/// Every pixel has full alpha, it can be copied as is.
+	Opacity_Opaque,
+
+	/// Needs alpha blending.
+	Opacity_Mixed
+};
+
 /// A 8x8 32bit RGBA sprite.
 struct sprite
 {
-	/// The actual color values for the pixels.
+	/// The actual color values for the pixels, premultiplied with their
+	/// alpha.
 	struct color pixels[k_sprite_size][k_sprite_size];
+
+	/// Opacity of each row, an enum sprite_opacity.
+	uint8_t row_opacity[k_sprite_size];
+
+	/// Opacity of the whole sprite, an enum sprite_opacity.
+	uint8_t opacity;
 };
 
-DEFINE_GROWABLE_BUFFER(struct sprite, sprite_buffer)
+enum
+{
+	/// Sprites allocated at once by the sprite manager. A whole
+	/// background fits in one chunk.
+	k_sprite_chunk_size = 2048,
+
+	/// Maximum count of sprite chunks.
+	k_sprite_max_chunks = 64,
+};
+
+DEFINE_CHUNKED_BUFFER(struct sprite, sprite_buffer, k_sprite_chunk_size,
+	k_sprite_max_chunks)
+
+/// Classifies the opacity of a span of pixels.
+///
+/// @param[in] pixels The pixels.
+/// @param[in] count Count of pixels.
+/// @return The opacity of the span.
+static inline enum sprite_opacity sprite_classify_span(const struct color* pixels,
+	int count)
+{
+	bool any_opaque = false;
+	bool any_transparent = false;
+	for (int i = 0; i < count; ++i)
+	{
+		if (pixels[i].a == 0xFF)
+			any_opaque = true;
+		else if (pixels[i].a == 0)
+			any_transparent = true;
+		else
+			return Opacity_Mixed;
+	}
+	return any_opaque && any_transparent ? Opacity_Mixed
+		: any_opaque ? Opacity_Opaque : Opacity_Transparent;
+}
+
+/// Fills the opacity information of a sprite from its pixels.
+///
+/// @param[in,out] sprite The sprite to classify.
+static inline void sprite_classify(struct sprite* sprite)
+{
+	int opaque = 0;
+	int transparent = 0;
+	for (int i = 0; i < k_sprite_size; ++i)
+	{
+		const enum sprite_opacity row =
+			sprite_classify_span(sprite->pixels[i], k_sprite_size);
+		sprite->row_opacity[i] = (uint8_t)row;
+		opaque += row == Opacity_Opaque;
+		transparent += row == Opacity_Transparent;
+	}
+	sprite->opacity = (uint8_t)(opaque == k_sprite_size ? Opacity_Opaque
+		: transparent == k_sprite_size ? Opacity_Transparent
+		: Opacity_Mixed);
+}
+
+/// Prepares a freshly loaded sprite for drawing.
+///
+/// Classifies the opacity, converts the pixels to the native channel
+/// order and premultiplies them with their alpha.
+///
+/// @param[in,out] sprite The sprite with straight alpha RGBA pixels.
+static inline void sprite_prepare(struct sprite* sprite)
+{
+	sprite_classify(sprite);
+	for (int i = 0; i < k_sprite_size; ++i)
+		for (int j = 0; j < k_sprite_size; ++j)
+			sprite->pixels[i][j] = color_premultiply(
+				color_from_rgba_bytes(sprite->pixels[i][j]));
+}
 
 /// Loads one or more sprites from a file.
 ///
 /// @param[in] file Path of file to load sprites from.
 /// @param[out] dst Target memory.
 /// @param[in] count Count of the sprites.
-inline void sprite_load_from_file(const char* file, struct sprite* dst,
+static inline void sprite_load_from_file(const char* file, struct sprite* dst,
 	int count)
 {
+	const size_t size = sizeof(dst->pixels);
+	uint8_t* data = (uint8_t*)malloc(count * size);
+	assert(data);
+
 	FILE* fp = fopen(file, "rb");
 	assert(fp);
-	size_t read = fread(dst, sizeof(struct sprite), count, fp);
+	size_t read = fread(data, size, count, fp);
 	assert(read == (size_t)count);
 	int close = fclose(fp);
 	assert(close == 0);
+
+	for (int i = 0; i < count; ++i)
+	{
+		memcpy(dst[i].pixels, &data[i * size], size);
+		sprite_prepare(&dst[i]);
+	}
+
+	free(data);
 }
 
 /// Loads sprites from a file that is multiple of k_sprite_size pixels
@@ -43,16 +146,16 @@ inline void sprite_load_from_file(const char* file, struct sprite* dst,
 /// @param[out] dst Target memory.
 /// @param[in] x Vertical count of sprites.
 /// @param[in] y Horizontal count of sprites.
-inline void sprite_load_from_file_2d(const char* file,
+static inline void sprite_load_from_file_2d(const char* file,
 	struct sprite* dst, int x, int y)
 {
 	struct color* data = (struct color*)malloc(
-		x * y * sizeof(struct sprite));
+		x * y * sizeof(dst->pixels));
 	assert(data);
 
 	FILE* fp = fopen(file, "rb");
 	assert(fp);
-	size_t read = fread(data, sizeof(struct sprite), x * y, fp);
+	size_t read = fread(data, sizeof(dst->pixels), x * y, fp);
 	assert(read == (size_t)(x * y));
 	int close = fclose(fp);
 	assert(close == 0);
@@ -70,35 +173,55 @@ inline void sprite_load_from_file_2d(const char* file,
 					dst[i * x + j].pixels[k][l] = data[px];
 				}
 
+	for (int i = 0; i < x * y; ++i)
+		sprite_prepare(&dst[i]);
+
 	free(data);
 }
 
 /// Draws a sprite onto a bitmap.
 ///
 /// Draws the given sprite onto a given position on the target bitmap
-/// with alpha blending.
+/// with alpha blending. The sprite is clipped once, then drawn row by
+/// row: opaque rows are copied, transparent ones are skipped, and only
+/// mixed rows are blended with blend_span(). Only pixels inside the
+/// clip rectangle are touched, the sprite may be partially or fully
+/// outside of it.
 ///
 /// @param[in,out] map Target bitmap.
 /// @param[in] map_w Map width.
-/// @param[in] map_h Map height.
+/// @param[in] clip Rectangle to draw into, must be inside the bitmap.
 /// @param[in] sprite The sprite to draw.
 /// @param[in] x X coordiante of where to draw the sprite.
 /// @param[in] y Y coordiante of where to draw the sprite.
-inline void sprite_draw_on_bitmap(
-	struct color* map, int map_w, int map_h,
+static inline void sprite_draw_on_bitmap(
+	struct color* map, int map_w, const struct rect* clip,
 	const struct sprite* sprite, int x, int y)
 {
-	for (int k = 0; k < k_sprite_size; ++k)
+	if (sprite->opacity == Opacity_Transparent)
+		return;
+
+	const struct rect area = rect_intersect(*clip,
+		rect_create(x, y, x + k_sprite_size, y + k_sprite_size));
+	if (rect_area(area) == 0)
+		return;
+
+	const int first = area.left - x;
+	const size_t width = (size_t)(area.right - area.left);
+	struct color* target = &map[area.top * map_w + area.left];
+	for (int l = area.top - y; l < area.bottom - y; ++l, target += map_w)
 	{
-		for (int l = 0; l < k_sprite_size; ++l)
+		const struct color* source = &sprite->pixels[l][first];
+		switch (sprite->row_opacity[l])
 		{
-			int px_y = y + l;
-			int px_x = x + k;
-			if (px_y < map_h && px_x < map_w && px_y > 0 && px_x > 0)
-			{
-				struct color* target = &map[px_y * map_w + px_x];
-				*target = color_alpha_blend(*target, sprite->pixels[l][k]);
-			}
+		case Opacity_Opaque:
+			memcpy(target, source, width * sizeof(struct color));
+			break;
+		case Opacity_Mixed:
+			blend_span(target, source, (int)width);
+			break;
+		default:
+			break;
 		}
 	}
 }
@@ -110,6 +233,8 @@ extern int sprite_manager_load_from_file(const char* file, const int count);
 extern int sprite_manager_load_from_file_2d(const char* file,
 	int x, int y);
 
+extern int sprite_manager_add(const struct sprite* sprites, int count);
+
 extern const struct sprite* sprite_manager_get_by_id(int id);
 
 /// @}
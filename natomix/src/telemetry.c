@@ -0,0 +1,277 @@
+/// @file telemetry.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Timing of the stages of a tick.
+///
+/// Every stage has a log-linear histogram of its durations: each power
+/// of two is split into k_histogram_sub_count buckets, so percentiles are
+/// within 12.5% at any scale, in a few kilobytes and without allocating.
+/// Counters of a frame, like the pixels it touched, use the same
+/// histograms.
+
+#include "pch.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include "globals.h"
+#include "thread.h"
+#include "telemetry.h"
+
+/// @addtogroup telemetry
+/// @{
+
+enum
+{
+	/// Bits of a duration below its highest set bit that pick a bucket.
+	k_histogram_sub_bits = 3,
+
+	/// Buckets per power of two.
+	k_histogram_sub_count = 1 << k_histogram_sub_bits,
+
+	/// Buckets of a histogram, enough for any 64 bit duration.
+	k_histogram_buckets = (64 - k_histogram_sub_bits + 1) * k_histogram_sub_count,
+};
+
+/// Nanoseconds in a tick at k_tickrate.
+static const long long k_tick_budget = 1000000000LL / k_tickrate;
+
+/// Durations of a stage, or values of a counter.
+struct histogram
+{
+	/// Count of durations in each bucket.
+	uint32_t buckets[k_histogram_buckets];
+
+	/// Count of durations.
+	long long count;
+
+	/// Sum of durations in nanoseconds.
+	long long sum;
+
+	/// Longest duration in nanoseconds.
+	long long max;
+
+	/// Count of durations longer than a tick.
+	long long over_budget;
+};
+
+/// Names of the stages in the report.
+static const char* const k_stage_names[TelemetryStage_Count] =
+{
+	"input",
+	"menu",
+	"gameplay",
+	"highscores",
+	"tick",
+	"submit",
+	"rasterize",
+	"present",
+};
+
+/// Names of the counters in the report.
+static const char* const k_counter_names[TelemetryCounter_Count] =
+{
+	"pixels",
+};
+
+/// Telemetry state.
+static struct
+{
+	/// Guards the histograms, stages are recorded from several threads.
+	struct mutex mutex;
+
+	/// Histogram of every stage.
+	struct histogram stages[TelemetryStage_Count];
+
+	/// Histogram of every counter.
+	struct histogram counters[TelemetryCounter_Count];
+} s_telemetry;
+
+/// Get the monotonic time.
+///
+/// @return Monotonic time in nanoseconds.
+long long telemetry_now(void)
+{
+#ifdef _WIN32
+	static long long s_frequency;
+	LARGE_INTEGER counter;
+	if (!s_frequency)
+	{
+		QueryPerformanceFrequency(&counter);
+		s_frequency = counter.QuadPart;
+	}
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart / s_frequency * 1000000000LL
+		+ counter.QuadPart % s_frequency * 1000000000LL / s_frequency;
+#else
+	struct timespec ts;
+	const int result = clock_gettime(CLOCK_MONOTONIC, &ts);
+	assert(result == 0);
+	(void)result;
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+/// Get the bucket of a duration.
+///
+/// @param[in] ns The duration.
+/// @return Index of the bucket.
+static int bucket_of(uint64_t ns)
+{
+	if (ns < k_histogram_sub_count)
+		return (int)ns;
+
+	int msb = 0;
+	while (ns >> (msb + 1))
+		++msb;
+
+	const int sub = (int)(ns >> (msb - k_histogram_sub_bits))
+		& (k_histogram_sub_count - 1);
+	return (msb - k_histogram_sub_bits + 1) * k_histogram_sub_count + sub;
+}
+
+/// Get the shortest duration of a bucket.
+///
+/// @param[in] bucket Index of the bucket.
+/// @return The duration in nanoseconds.
+static uint64_t bucket_floor(int bucket)
+{
+	if (bucket < k_histogram_sub_count)
+		return (uint64_t)bucket;
+
+	const int msb = bucket / k_histogram_sub_count + k_histogram_sub_bits - 1;
+	const uint64_t sub = bucket % k_histogram_sub_count;
+	return (k_histogram_sub_count + sub) << (msb - k_histogram_sub_bits);
+}
+
+/// Initialize the telemetry.
+///
+/// Must be called before any other thread is started.
+void telemetry_init(void)
+{
+	mutex_init(&s_telemetry.mutex);
+}
+
+/// Add a value to a histogram.
+///
+/// @warning Must be called with the mutex held.
+///
+/// @param[in,out] histogram The histogram.
+/// @param[in] value The value, not negative.
+static void histogram_add(struct histogram* histogram, long long value)
+{
+	++histogram->buckets[bucket_of((uint64_t)value)];
+	++histogram->count;
+	histogram->sum += value;
+	histogram->max = MAX(histogram->max, value);
+}
+
+/// Record how long a stage took.
+///
+/// @param[in] stage The stage.
+/// @param[in] ns Duration in nanoseconds.
+void telemetry_record(enum telemetry_stage stage, long long ns)
+{
+	assert(stage >= 0 && stage < TelemetryStage_Count);
+	ns = MAX(ns, 0);
+
+	mutex_lock(&s_telemetry.mutex);
+	struct histogram* histogram = &s_telemetry.stages[stage];
+	histogram_add(histogram, ns);
+	histogram->over_budget += ns > k_tick_budget;
+	mutex_unlock(&s_telemetry.mutex);
+}
+
+/// Record a counter of a frame.
+///
+/// @param[in] counter The counter.
+/// @param[in] value Its value in the frame.
+void telemetry_count(enum telemetry_counter counter, long long value)
+{
+	assert(counter >= 0 && counter < TelemetryCounter_Count);
+
+	mutex_lock(&s_telemetry.mutex);
+	histogram_add(&s_telemetry.counters[counter], MAX(value, 0));
+	mutex_unlock(&s_telemetry.mutex);
+}
+
+/// Get a percentile of a histogram.
+///
+/// @param[in] histogram The histogram.
+/// @param[in] percentile The percentile, between 0 and 100.
+/// @return Upper bound of the bucket the percentile is in, in nanoseconds.
+static long long histogram_percentile(const struct histogram* histogram,
+	double percentile)
+{
+	const long long rank =
+		(long long)ceil(histogram->count * percentile / 100.0);
+	long long seen = 0;
+	for (int i = 0; i < k_histogram_buckets; ++i)
+	{
+		seen += histogram->buckets[i];
+		if (seen >= MAX(rank, 1))
+			return MIN((long long)bucket_floor(i + 1) - 1, histogram->max);
+	}
+	return histogram->max;
+}
+
+/// Print the timing of every stage and the counters recorded so far.
+///
+/// Durations are in microseconds. "over" is the count of times a stage
+/// took longer than a whole tick. Counters are per frame.
+///
+/// @param[in] print Function printing a line.
+void telemetry_report(telemetry_print_fn print)
+{
+	mutex_lock(&s_telemetry.mutex);
+
+	char line[160];
+	snprintf(line, sizeof(line),
+		"%-10s %9s %9s %9s %9s %9s %9s %9s %7s\n", "stage", "count",
+		"mean", "p50", "p90", "p99", "p99.9", "max", "over");
+	print(line);
+
+	for (int i = 0; i < TelemetryStage_Count; ++i)
+	{
+		const struct histogram* histogram = &s_telemetry.stages[i];
+		if (!histogram->count)
+			continue;
+
+		snprintf(line, sizeof(line),
+			"%-10s %9lld %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %7lld\n",
+			k_stage_names[i], histogram->count,
+			histogram->sum / 1000.0 / histogram->count,
+			histogram_percentile(histogram, 50) / 1000.0,
+			histogram_percentile(histogram, 90) / 1000.0,
+			histogram_percentile(histogram, 99) / 1000.0,
+			histogram_percentile(histogram, 99.9) / 1000.0,
+			histogram->max / 1000.0,
+			histogram->over_budget);
+		print(line);
+	}
+
+	for (int i = 0; i < TelemetryCounter_Count; ++i)
+	{
+		const struct histogram* histogram = &s_telemetry.counters[i];
+		if (!histogram->count)
+			continue;
+
+		snprintf(line, sizeof(line),
+			"%-10s %9lld %9.0f %9lld %9lld %9lld %9lld %9lld\n",
+			k_counter_names[i], histogram->count,
+			(double)histogram->sum / histogram->count,
+			histogram_percentile(histogram, 50),
+			histogram_percentile(histogram, 90),
+			histogram_percentile(histogram, 99),
+			histogram_percentile(histogram, 99.9),
+			histogram->max);
+		print(line);
+	}
+
+	mutex_unlock(&s_telemetry.mutex);
+}
+
+/// @}
@@ -0,0 +1,69 @@
+/// @file telemetry.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Timing of the stages of a tick.
+
+#pragma once
+
+/// @addtogroup telemetry
+/// @{
+
+/// Timed stages of a tick.
+enum telemetry_stage
+{
+	/// Applying input to the key states.
+	TelemetryStage_Input,
+
+	/// Menu logic and its draw commands.
+	TelemetryStage_Menu,
+
+	/// Gameplay logic and its draw commands.
+	TelemetryStage_Gameplay,
+
+	/// Highscore logic and its draw commands.
+	TelemetryStage_Highscores,
+
+	/// The whole on_game_tick().
+	TelemetryStage_Tick,
+
+	/// Handing the commands to the render thread, including waiting for
+	/// it to finish the previous frame.
+	TelemetryStage_Submit,
+
+	/// Rasterizing a frame on the render thread.
+	TelemetryStage_Rasterize,
+
+	/// Converting and presenting a frame on the platform.
+	TelemetryStage_Present,
+
+	/// Count of stages.
+	TelemetryStage_Count
+};
+
+/// Counted quantities of a frame.
+enum telemetry_counter
+{
+	/// Pixels written while rasterizing a frame, including restoring the
+	/// background of the dirty cells.
+	TelemetryCounter_PixelsTouched,
+
+	/// Count of counters.
+	TelemetryCounter_Count
+};
+
+/// Prints a line of the report.
+///
+/// @param[in] line The line, including the newline.
+typedef void(*telemetry_print_fn)(const char* line);
+
+extern void telemetry_init(void);
+
+extern long long telemetry_now(void);
+
+extern void telemetry_record(enum telemetry_stage stage, long long ns);
+
+extern void telemetry_count(enum telemetry_counter counter, long long value);
+
+extern void telemetry_report(telemetry_print_fn print);
+
+/// @}
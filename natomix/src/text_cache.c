@@ -0,0 +1,173 @@
+/// @file text_cache.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Text raster cache implementation.
+///
+/// Strings are looked up by font and content. When a string changes,
+/// the raster it used last frame at the same position is patched, and
+/// only the glyphs that differ are copied again.
+
+#include "pch.h"
+
+#include "text_cache.h"
+#include "sprite_manager.h"
+
+/// @addtogroup text_cache
+/// @{
+
+enum
+{
+	/// Count of cached rasters.
+	k_text_cache_size = 64,
+};
+
+/// The cached rasters.
+static struct text_raster s_rasters[k_text_cache_size];
+
+/// Count of rasters in use.
+static int s_raster_count;
+
+/// Current frame, starts at 1 so unused rasters are never current.
+static uint32_t s_frame = 1;
+
+/// Start a new frame.
+///
+/// Rasters used in the previous frames may be reused after this.
+void text_cache_start_frame(void)
+{
+	s_frame++;
+}
+
+/// Copy the glyphs that differ from the cached string into a raster.
+///
+/// @param[in,out] raster The raster to update.
+/// @param[in] font_sprite Sprite ID for the \0 character of the font.
+/// @param[in] str The new string.
+/// @param[in] len Length of the string.
+static void update_raster(struct text_raster* raster, int font_sprite,
+	const char* str, int len)
+{
+	const bool same_font = raster->font_sprite == font_sprite;
+	for (int i = 0; i < len; ++i)
+	{
+		if (same_font && i < raster->len && raster->str[i] == str[i])
+			continue;
+
+		const struct sprite* glyph =
+			sprite_manager_get_by_id(font_sprite + ((uint8_t*)str)[i]);
+		for (int k = 0; k < k_sprite_size; ++k)
+			memcpy(&raster->pixels[k][i * k_sprite_size], glyph->pixels[k],
+				sizeof(glyph->pixels[k]));
+	}
+
+	raster->font_sprite = font_sprite;
+	raster->len = len;
+	memcpy(raster->str, str, len);
+	raster->str[len] = 0;
+
+	for (int k = 0; k < k_sprite_size; ++k)
+		raster->row_opacity[k] = (uint8_t)sprite_classify_span(
+			raster->pixels[k], len * k_sprite_size);
+}
+
+/// Get the raster of a string.
+///
+/// Returns the cached raster if the same string was drawn before with
+/// the same font. Otherwise the raster last drawn at the same position
+/// is updated, so a changing number only costs the changed digits.
+/// Failing that, the least recently used raster is replaced.
+///
+/// @param[in] font_sprite Sprite ID for the \0 character of the font.
+/// @param[in] x Horizontal position the string is drawn to.
+/// @param[in] y Vertical position the string is drawn to.
+/// @param[in] str The string.
+/// @param[in] len Length of the string.
+/// @return The raster, or NULL if the string can not be cached.
+/// @warning The raster is only valid until the next frame.
+const struct text_raster* text_cache_get(int font_sprite, int x, int y,
+	const char* str, int len)
+{
+	if (len > k_text_raster_max_len || len == 0)
+		return NULL;
+
+	struct text_raster* same_place = NULL;
+	struct text_raster* oldest = NULL;
+	for (int i = 0; i < s_raster_count; ++i)
+	{
+		struct text_raster* raster = &s_rasters[i];
+		if (raster->font_sprite == font_sprite && raster->len == len
+			&& memcmp(raster->str, str, len) == 0)
+		{
+			raster->x = x;
+			raster->y = y;
+			raster->last_used = s_frame;
+			return raster;
+		}
+
+		// Rasters of this frame may still be drawn
+		if (raster->last_used == s_frame)
+			continue;
+
+		if (raster->x == x && raster->y == y)
+			same_place = raster;
+		if (!oldest || raster->last_used < oldest->last_used)
+			oldest = raster;
+	}
+
+	struct text_raster* raster = same_place ? same_place : oldest;
+	if (s_raster_count < k_text_cache_size && !same_place)
+	{
+		raster = &s_rasters[s_raster_count++];
+		raster->len = 0;
+		raster->font_sprite = -1;
+	}
+	if (!raster)
+		return NULL;
+
+	update_raster(raster, font_sprite, str, len);
+	raster->x = x;
+	raster->y = y;
+	raster->last_used = s_frame;
+	return raster;
+}
+
+/// Draws a text raster onto a bitmap.
+///
+/// Same as drawing the glyphs one by one with sprite_draw_on_bitmap(),
+/// but in whole rows.
+///
+/// @param[in,out] map Target bitmap.
+/// @param[in] map_w Map width.
+/// @param[in] clip Rectangle to draw into, must be inside the bitmap.
+/// @param[in] raster The raster to draw.
+/// @param[in] x X coordiante of where to draw the string.
+/// @param[in] y Y coordiante of where to draw the string.
+void text_raster_draw_on_bitmap(struct color* map, int map_w,
+	const struct rect* clip, const struct text_raster* raster, int x, int y)
+{
+	const struct rect area = rect_intersect(*clip, rect_create(x, y,
+		x + raster->len * k_sprite_size, y + k_sprite_size));
+	if (rect_area(area) == 0)
+		return;
+
+	const int first = area.left - x;
+	const size_t width = (size_t)(area.right - area.left);
+	struct color* target = &map[area.top * map_w + area.left];
+	for (int l = area.top - y; l < area.bottom - y; ++l, target += map_w)
+	{
+		const struct color* source = &raster->pixels[l][first];
+		switch (raster->row_opacity[l])
+		{
+		case Opacity_Opaque:
+			memcpy(target, source, width * sizeof(struct color));
+			break;
+		case Opacity_Mixed:
+			blend_span(target, source, (int)width);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/// @}
@@ -0,0 +1,56 @@
+/// @file text_cache.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Cache of strings rasterized into single images.
+
+#pragma once
+#include "color.h"
+#include "globals.h"
+#include "rect.h"
+
+/// @addtogroup text_cache
+/// @{
+
+enum
+{
+	/// Longest string that can be cached.
+	k_text_raster_max_len = 64,
+};
+
+/// A string rasterized with a font, one glyph after the other.
+struct text_raster
+{
+	/// Sprite ID for the \0 character of the font.
+	int font_sprite;
+
+	/// Length of the string.
+	int len;
+
+	/// The string.
+	char str[k_text_raster_max_len + 1];
+
+	/// Where the string was drawn last.
+	int x;
+
+	/// Where the string was drawn last.
+	int y;
+
+	/// Frame the raster was last used in.
+	uint32_t last_used;
+
+	/// Opacity of each row, an enum sprite_opacity.
+	uint8_t row_opacity[k_sprite_size];
+
+	/// The premultiplied pixels, only the first len glyphs are valid.
+	struct color pixels[k_sprite_size][k_text_raster_max_len * k_sprite_size];
+};
+
+extern void text_cache_start_frame(void);
+
+extern const struct text_raster* text_cache_get(int font_sprite, int x,
+	int y, const char* str, int len);
+
+extern void text_raster_draw_on_bitmap(struct color* map, int map_w,
+	const struct rect* clip, const struct text_raster* raster, int x, int y);
+
+/// @}
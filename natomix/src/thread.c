@@ -0,0 +1,224 @@
+/// @file thread.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Threading primitives implementation.
+
+#include "pch.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "thread.h"
+
+/// @addtogroup thread
+/// @{
+
+/// What a new thread needs to start.
+struct thread_start
+{
+	/// Entry point.
+	thread_fn fn;
+
+	/// Argument of the entry point.
+	void* arg;
+};
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param)
+{
+	struct thread_start start = *(struct thread_start*)param;
+	free(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+#else
+
+static void* thread_entry(void* param)
+{
+	struct thread_start start = *(struct thread_start*)param;
+	free(param);
+	start.fn(start.arg);
+	return NULL;
+}
+
+#endif
+
+/// Start a new thread.
+///
+/// @param[out] thread The thread.
+/// @param[in] fn Entry point of the thread.
+/// @param[in] arg Argument of the entry point.
+/// @return True if the thread started.
+bool thread_create(struct thread* thread, thread_fn fn, void* arg)
+{
+	struct thread_start* start =
+		(struct thread_start*)malloc(sizeof(struct thread_start));
+	assert(start);
+	start->fn = fn;
+	start->arg = arg;
+
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, &thread_entry, start, 0, NULL);
+	const bool result = thread->handle != NULL;
+#else
+	const bool result =
+		pthread_create(&thread->handle, NULL, &thread_entry, start) == 0;
+#endif
+
+	if (!result)
+		free(start);
+	return result;
+}
+
+/// Wait for a thread to exit, and free it.
+///
+/// @param[in,out] thread The thread.
+void thread_join(struct thread* thread)
+{
+#ifdef _WIN32
+	DWORD result = WaitForSingleObject(thread->handle, INFINITE);
+	assert(result == WAIT_OBJECT_0);
+	(void)result;
+	BOOL closed = CloseHandle(thread->handle);
+	assert(closed);
+	(void)closed;
+#else
+	int result = pthread_join(thread->handle, NULL);
+	assert(result == 0);
+	(void)result;
+#endif
+}
+
+/// Get the count of hardware threads.
+///
+/// @return Count of logical processors, at least 1.
+int thread_hardware_concurrency(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const long count = (long)info.dwNumberOfProcessors;
+#else
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? (int)count : 1;
+}
+
+/// Initialize a mutex.
+/// @param[out] mutex The mutex.
+void mutex_init(struct mutex* mutex)
+{
+#ifdef _WIN32
+	InitializeSRWLock((PSRWLOCK)&mutex->lock);
+#else
+	int result = pthread_mutex_init(&mutex->lock, NULL);
+	assert(result == 0);
+	(void)result;
+#endif
+}
+
+/// Free a mutex.
+/// @param[in,out] mutex The mutex.
+void mutex_destroy(struct mutex* mutex)
+{
+#ifdef _WIN32
+	(void)mutex;
+#else
+	pthread_mutex_destroy(&mutex->lock);
+#endif
+}
+
+/// Lock a mutex.
+/// @param[in,out] mutex The mutex.
+void mutex_lock(struct mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive((PSRWLOCK)&mutex->lock);
+#else
+	pthread_mutex_lock(&mutex->lock);
+#endif
+}
+
+/// Unlock a mutex.
+/// @param[in,out] mutex The mutex.
+void mutex_unlock(struct mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive((PSRWLOCK)&mutex->lock);
+#else
+	pthread_mutex_unlock(&mutex->lock);
+#endif
+}
+
+/// Initialize a condition variable.
+/// @param[out] cond The condition variable.
+void cond_init(struct cond* cond)
+{
+#ifdef _WIN32
+	InitializeConditionVariable((PCONDITION_VARIABLE)&cond->cv);
+#else
+	int result = pthread_cond_init(&cond->cv, NULL);
+	assert(result == 0);
+	(void)result;
+#endif
+}
+
+/// Free a condition variable.
+/// @param[in,out] cond The condition variable.
+void cond_destroy(struct cond* cond)
+{
+#ifdef _WIN32
+	(void)cond;
+#else
+	pthread_cond_destroy(&cond->cv);
+#endif
+}
+
+/// Wait on a condition variable.
+///
+/// Unlocks the mutex while waiting. May wake up spuriously.
+///
+/// @param[in,out] cond The condition variable.
+/// @param[in,out] mutex The locked mutex.
+void cond_wait(struct cond* cond, struct mutex* mutex)
+{
+#ifdef _WIN32
+	BOOL result = SleepConditionVariableSRW((PCONDITION_VARIABLE)&cond->cv,
+		(PSRWLOCK)&mutex->lock, INFINITE, 0);
+	assert(result);
+	(void)result;
+#else
+	pthread_cond_wait(&cond->cv, &mutex->lock);
+#endif
+}
+
+/// Wake up one thread waiting on a condition variable.
+/// @param[in,out] cond The condition variable.
+void cond_signal(struct cond* cond)
+{
+#ifdef _WIN32
+	WakeConditionVariable((PCONDITION_VARIABLE)&cond->cv);
+#else
+	pthread_cond_signal(&cond->cv);
+#endif
+}
+
+/// Wake up every thread waiting on a condition variable.
+/// @param[in,out] cond The condition variable.
+void cond_broadcast(struct cond* cond)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable((PCONDITION_VARIABLE)&cond->cv);
+#else
+	pthread_cond_broadcast(&cond->cv);
+#endif
+}
+
+/// @}
@@ -0,0 +1,95 @@
+/// @file thread.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Thin wrapper over the threading primitives of the platform.
+///
+/// Win32 threads, slim reader/writer locks and condition variables on
+/// Windows, pthreads everywhere else.
+
+#pragma once
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/// @addtogroup thread
+/// @{
+
+#ifdef _WIN32
+
+/// A thread.
+struct thread
+{
+	/// The thread HANDLE.
+	void* handle;
+};
+
+/// A mutex. Not recursive.
+struct mutex
+{
+	/// The SRWLOCK, which is pointer sized.
+	void* lock;
+};
+
+/// A condition variable.
+struct cond
+{
+	/// The CONDITION_VARIABLE, which is pointer sized.
+	void* cv;
+};
+
+#else
+
+/// A thread.
+struct thread
+{
+	/// The pthread.
+	pthread_t handle;
+};
+
+/// A mutex. Not recursive.
+struct mutex
+{
+	/// The pthread mutex.
+	pthread_mutex_t lock;
+};
+
+/// A condition variable.
+struct cond
+{
+	/// The pthread condition variable.
+	pthread_cond_t cv;
+};
+
+#endif
+
+/// Entry point of a thread.
+///
+/// @param[in] arg Argument given to thread_create().
+typedef void(*thread_fn)(void* arg);
+
+extern bool thread_create(struct thread* thread, thread_fn fn, void* arg);
+
+extern void thread_join(struct thread* thread);
+
+extern int thread_hardware_concurrency(void);
+
+extern void mutex_init(struct mutex* mutex);
+
+extern void mutex_destroy(struct mutex* mutex);
+
+extern void mutex_lock(struct mutex* mutex);
+
+extern void mutex_unlock(struct mutex* mutex);
+
+extern void cond_init(struct cond* cond);
+
+extern void cond_destroy(struct cond* cond);
+
+extern void cond_wait(struct cond* cond, struct mutex* mutex);
+
+extern void cond_signal(struct cond* cond);
+
+extern void cond_broadcast(struct cond* cond);
+
+/// @}
@@ -0,0 +1,182 @@
+/// @file thread_pool.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Thread pool implementation.
+///
+/// Workers sleep on a condition variable until thread_pool_run() hands
+/// out items, then take them one by one until none are left. The thread
+/// calling thread_pool_run() takes items as well.
+
+#include "pch.h"
+
+#include "globals.h"
+#include "thread.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+/// @addtogroup thread_pool
+/// @{
+
+enum
+{
+	/// Maximum count of worker threads.
+	k_max_threads = 64,
+};
+
+static struct
+{
+	/// The worker threads.
+	struct thread threads[k_max_threads];
+
+	/// Count of worker threads, not counting the caller of run.
+	int thread_count;
+
+	/// Protects everything below.
+	struct mutex lock;
+
+	/// Signaled when there are items or the pool is stopping.
+	struct cond work_cv;
+
+	/// Signaled when the last item is finished.
+	struct cond done_cv;
+
+	/// The current job.
+	thread_pool_fn fn;
+
+	/// Context of the current job.
+	void* ctx;
+
+	/// Count of items in the current job.
+	int count;
+
+	/// Next item to hand out.
+	int next;
+
+	/// Count of items not finished yet.
+	int pending;
+
+	/// True if the workers should exit.
+	bool stopping;
+} s_pool;
+
+/// Take the next item of the job, and run it.
+///
+/// Must be called with the lock held, returns with it held.
+static void run_one(void)
+{
+	const int index = s_pool.next++;
+	const thread_pool_fn fn = s_pool.fn;
+	void* const ctx = s_pool.ctx;
+
+	mutex_unlock(&s_pool.lock);
+	fn(ctx, index);
+	mutex_lock(&s_pool.lock);
+
+	if (--s_pool.pending == 0)
+		cond_broadcast(&s_pool.done_cv);
+}
+
+/// Worker thread entry point.
+/// @param[in] arg Unused.
+static void worker(void* arg)
+{
+	(void)arg;
+	trace_name_thread("pool worker");
+	mutex_lock(&s_pool.lock);
+	for (;;)
+	{
+		while (!s_pool.stopping && s_pool.next >= s_pool.count)
+			cond_wait(&s_pool.work_cv, &s_pool.lock);
+		if (s_pool.stopping)
+			break;
+		run_one();
+	}
+	mutex_unlock(&s_pool.lock);
+}
+
+/// Start the thread pool.
+///
+/// @param[in] count Count of threads to run jobs on, including the one
+///                  calling thread_pool_run().
+void thread_pool_start(int count)
+{
+	assert(s_pool.thread_count == 0);
+	mutex_init(&s_pool.lock);
+	cond_init(&s_pool.work_cv);
+	cond_init(&s_pool.done_cv);
+	s_pool.count = 0;
+	s_pool.next = 0;
+	s_pool.pending = 0;
+	s_pool.stopping = false;
+
+	CLAMP_IN_PLACE(count, 1, k_max_threads + 1);
+	for (int i = 0; i < count - 1; ++i)
+	{
+		if (!thread_create(&s_pool.threads[i], &worker, NULL))
+			break;
+		s_pool.thread_count++;
+	}
+}
+
+/// Stop the thread pool, and wait for the workers to exit.
+void thread_pool_stop(void)
+{
+	if (s_pool.thread_count == 0)
+		return;
+
+	mutex_lock(&s_pool.lock);
+	s_pool.stopping = true;
+	cond_broadcast(&s_pool.work_cv);
+	mutex_unlock(&s_pool.lock);
+
+	for (int i = 0; i < s_pool.thread_count; ++i)
+		thread_join(&s_pool.threads[i]);
+	s_pool.thread_count = 0;
+
+	cond_destroy(&s_pool.done_cv);
+	cond_destroy(&s_pool.work_cv);
+	mutex_destroy(&s_pool.lock);
+}
+
+/// Get the count of threads running jobs.
+///
+/// @return Count of threads, including the caller of thread_pool_run().
+int thread_pool_size(void)
+{
+	return s_pool.thread_count + 1;
+}
+
+/// Run a job on the pool.
+///
+/// Calls the function once for every index from 0 to count - 1, in no
+/// particular order, and waits for all of them to finish. Only one job
+/// may run at a time.
+///
+/// @param[in] fn The function to run.
+/// @param[in] ctx Context passed to the function.
+/// @param[in] count Count of items.
+void thread_pool_run(thread_pool_fn fn, void* ctx, int count)
+{
+	if (s_pool.thread_count == 0)
+	{
+		for (int i = 0; i < count; ++i)
+			fn(ctx, i);
+		return;
+	}
+
+	mutex_lock(&s_pool.lock);
+	s_pool.fn = fn;
+	s_pool.ctx = ctx;
+	s_pool.count = count;
+	s_pool.next = 0;
+	s_pool.pending = count;
+	cond_broadcast(&s_pool.work_cv);
+
+	while (s_pool.next < s_pool.count)
+		run_one();
+	while (s_pool.pending > 0)
+		cond_wait(&s_pool.done_cv, &s_pool.lock);
+	mutex_unlock(&s_pool.lock);
+}
+
+/// @}
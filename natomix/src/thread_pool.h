@@ -0,0 +1,25 @@
+/// @file thread_pool.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief A pool of worker threads running indexed jobs.
+
+#pragma once
+
+/// @addtogroup thread_pool
+/// @{
+
+/// A job run by the pool.
+///
+/// @param[in] ctx Context given to thread_pool_run().
+/// @param[in] index Index of the item to process.
+typedef void(*thread_pool_fn)(void* ctx, int index);
+
+extern void thread_pool_start(int count);
+
+extern void thread_pool_stop(void);
+
+extern int thread_pool_size(void);
+
+extern void thread_pool_run(thread_pool_fn fn, void* ctx, int count);
+
+/// @}
@@ -5,13 +5,16 @@
 
 #include "pch.h"
 
-#include "growable_buffer2.h"
+#include "chunked_buffer.h"
 #include "tile_manager.h"
 
 /// @addtogroup tiles
 /// @{
 
-DEFINE_GROWABLE_BUFFER(struct tile, tile_buffer);
+/// Tiles allocated at once.
+enum { k_tile_chunk_size = 1024 };
+
+DEFINE_CHUNKED_BUFFER(struct tile, tile_buffer, k_tile_chunk_size, 64)
 
 static struct tile_buffer s_tiles;
 
@@ -40,11 +43,10 @@ int tile_manager_add(int start, int width, int height)
 /// Get a pointer to the tile identified by ID.
 ///
 /// @param[in] id The id of the tile.
-/// @return Pointer to the tile.
-/// @warning The pointer may become invalid when adding a new tile.
+/// @return Pointer to the tile, valid for the whole run.
 const struct tile* tile_manager_get_by_id(int id)
 {
-	return &(s_tiles.mem)[id];
+	return tile_buffer_at(&s_tiles, id);
 }
 
 /// @}
@@ -28,7 +28,7 @@ struct tile
 /// @param[in] width Width in sprites
 /// @param[in] height Height in sprites
 /// @return The tile.
-inline struct tile tile_create(int start_id, int width, int height)
+static inline struct tile tile_create(int start_id, int width, int height)
 {
 	struct tile t;
 	t.start_id = start_id;
@@ -43,16 +43,16 @@ inline struct tile tile_create(int start_id, int width, int height)
 ///
 /// @param[in,out] map The bitmap to draw to.
 /// @param[in] map_w Width of the bitmap.
-/// @param[in] map_h Height of the bitmap.
+/// @param[in] clip Rectangle to draw into, must be inside the bitmap.
 /// @param[in] tile Pointer to the tile to draw.
 /// @param[in] x Vertical position to draw to.
 /// @param[in] y Horizontal position to draw to.
-inline void tile_draw_on_bitmap(struct color* map, int map_w, int map_h,
-	const struct tile* tile, int x, int y)
+static inline void tile_draw_on_bitmap(struct color* map, int map_w,
+	const struct rect* clip, const struct tile* tile, int x, int y)
 {
 	for (int i = 0; i < tile->width; ++i)
 		for (int j = 0; j < tile->height; ++j)
-			sprite_draw_on_bitmap(map, map_w, map_h,
+			sprite_draw_on_bitmap(map, map_w, clip,
 				sprite_manager_get_by_id(tile->start_id + j * tile->width + i),
 				x + i * k_sprite_size, y + j * k_sprite_size);
 }
@@ -0,0 +1,197 @@
+/// @file trace.c
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Trace event recording for trace viewers.
+///
+/// Spans are recorded into a buffer owned by the recording thread, so
+/// recording never takes a lock. A thread's buffer is linked into a
+/// global list with a compare and swap the first time it records. On
+/// stop, every buffer is written out as Chrome trace event JSON, which
+/// chrome://tracing and Perfetto load.
+
+#include "pch.h"
+
+#include "atomics.h"
+#include "growable_buffer2.h"
+#include "telemetry.h"
+#include "trace.h"
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL __thread
+#endif
+
+/// @addtogroup trace
+/// @{
+
+/// A finished span.
+struct trace_event
+{
+	/// Name of the span, must be a string literal.
+	const char* name;
+
+	/// When the span started, in nanoseconds of telemetry_now().
+	long long start;
+
+	/// How long the span took in nanoseconds.
+	long long duration;
+};
+
+DEFINE_GROWABLE_BUFFER(struct trace_event, trace_event_buffer)
+
+/// The spans of a thread.
+struct trace_thread
+{
+	/// The spans, only touched by the owning thread until stopped.
+	struct trace_event_buffer events;
+
+	/// Name of the thread, NULL if not named.
+	const char* name;
+
+	/// Thread ID in the trace.
+	int tid;
+
+	/// Next thread in the list.
+	struct trace_thread* next;
+};
+
+/// Trace state.
+static struct
+{
+	/// The file being written, NULL if not tracing.
+	FILE* fp;
+
+	/// When tracing started, in nanoseconds of telemetry_now().
+	long long epoch;
+
+	/// Every thread that recorded something.
+	struct trace_thread* volatile threads;
+
+	/// Count of threads in the list.
+	volatile int32_t thread_count;
+} s_trace;
+
+/// Spans of the current thread.
+static TRACE_THREAD_LOCAL struct trace_thread* s_thread;
+
+/// Get the spans of the current thread.
+///
+/// @return The thread's buffer, created and linked in on first use.
+static struct trace_thread* get_thread(void)
+{
+	if (s_thread)
+		return s_thread;
+
+	struct trace_thread* thread =
+		(struct trace_thread*)malloc(sizeof(struct trace_thread));
+	assert(thread);
+	trace_event_buffer_init(&thread->events);
+	thread->name = NULL;
+	thread->tid = atomic_fetch_add_i32(&s_trace.thread_count, 1) + 1;
+
+	struct trace_thread* head;
+	do
+	{
+		head = (struct trace_thread*)atomic_load_ptr(
+			(void* const volatile*)&s_trace.threads);
+		thread->next = head;
+	} while (!atomic_cas_ptr((void* volatile*)&s_trace.threads, head,
+		thread));
+
+	s_thread = thread;
+	return thread;
+}
+
+/// Start tracing.
+///
+/// Must be called before starting any thread that records spans.
+///
+/// @param[in] path File to write the trace to.
+/// @return True if succeeded.
+bool trace_start(const char* path)
+{
+	assert(!s_trace.fp);
+	s_trace.fp = fopen(path, "w");
+	if (!s_trace.fp)
+		return false;
+
+	s_trace.epoch = telemetry_now();
+	return true;
+}
+
+/// Stop tracing and write the trace.
+///
+/// Every thread recording spans must have finished already.
+void trace_stop(void)
+{
+	if (!s_trace.fp)
+		return;
+
+	FILE* fp = s_trace.fp;
+	fputs("{\"traceEvents\":[\n", fp);
+	bool first = true;
+	for (struct trace_thread* thread = s_trace.threads; thread;
+		thread = thread->next)
+	{
+		if (thread->name)
+		{
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+				"\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				first ? "" : ",\n", thread->tid, thread->name);
+			first = false;
+		}
+
+		for (int i = 0; i < thread->events.size; ++i)
+		{
+			const struct trace_event* event = &thread->events.mem[i];
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+				"\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", event->name, thread->tid,
+				(event->start - s_trace.epoch) / 1000.0,
+				event->duration / 1000.0);
+			first = false;
+		}
+	}
+	fputs("\n]}\n", fp);
+
+	const int result = fclose(fp);
+	assert(result == 0);
+	(void)result;
+	s_trace.fp = NULL;
+}
+
+/// Name the current thread in the trace.
+///
+/// @param[in] name The name, must be a string literal.
+void trace_name_thread(const char* name)
+{
+	if (s_trace.fp)
+		get_thread()->name = name;
+}
+
+/// Start a span.
+///
+/// @return Start of the span, 0 if not tracing.
+long long trace_begin(void)
+{
+	return s_trace.fp ? telemetry_now() : 0;
+}
+
+/// Finish a span.
+///
+/// @param[in] name Name of the span, must be a string literal.
+/// @param[in] start Value returned by trace_begin().
+void trace_end(const char* name, long long start)
+{
+	if (!start)
+		return;
+
+	struct trace_event event;
+	event.name = name;
+	event.start = start;
+	event.duration = telemetry_now() - start;
+	trace_event_buffer_push(&get_thread()->events, &event);
+}
+
+/// @}
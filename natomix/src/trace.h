@@ -0,0 +1,21 @@
+/// @file trace.h
+/// @author namazso
+/// @date 2026-10-17
+/// @brief Trace event recording for trace viewers.
+
+#pragma once
+
+/// @addtogroup trace
+/// @{
+
+extern bool trace_start(const char* path);
+
+extern void trace_stop(void);
+
+extern void trace_name_thread(const char* name);
+
+extern long long trace_begin(void);
+
+extern void trace_end(const char* name, long long start);
+
+/// @}
@@ -56,9 +56,15 @@
 #define NOTAPE
 #define ANSI_ONLY
 #include <windows.h>
+#include <mmsystem.h>
+
+#pragma comment(lib, "winmm.lib")
 
 #include "globals.h"
 #include "game.h"
+#include "input.h"
+#include "telemetry.h"
+#include "trace.h"
 
 /// @addtogroup windows
 /// @{
@@ -75,18 +81,344 @@ static int s_display_size_multiplier = 4;
 /// True until our game is running
 static bool s_is_running = true;
 
+/// The frame being presented, held from the renderer while it is painted.
+///
+/// The renderer already writes the BGRA order Windows wants, so the frame
+/// is handed to GDI as is.
+static const struct color* s_present_frame;
+
+/// Ticks can fall this far behind before the scheduler gives up on
+/// catching up and drops them.
+static const int k_max_catch_up_ticks = 8;
+
+/// Ticks run between handling window messages when fast forwarding.
+static const int k_fast_forward_batch = 64;
+
+/// How long before a tick deadline we stop sleeping and start spinning,
+/// in microseconds. Covers the wakeup latency of a high resolution timer.
+static const int k_spin_microseconds = 500;
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+/// Fixed timestep scheduler state.
+struct frame_scheduler
+{
+	/// QueryPerformanceCounter ticks per second.
+	long long frequency;
+
+	/// Counter value when the scheduler started.
+	long long start;
+
+	/// Number of game ticks scheduled since start.
+	long long ticks;
+
+	/// Run ticks as fast as possible instead of at k_tickrate.
+	bool fast_forward;
+
+	/// Ticks run in the current fast forward batch.
+	int batch;
+
+	/// Frames presented per second, 0 for every tick.
+	int present_rate;
+
+	/// Number of frames scheduled since start.
+	long long presents;
+
+	/// Value of ticks when the last frame was presented, when presenting
+	/// after every tick.
+	long long presented_ticks;
+
+	/// Sum of the lateness of every tick in counter ticks.
+	long long jitter_sum;
+
+	/// Largest lateness of a tick in counter ticks.
+	long long jitter_max;
+
+	/// Number of ticks measured for jitter.
+	long long jitter_count;
+
+	/// Number of ticks dropped because we fell too far behind.
+	long long dropped;
+
+	/// High resolution waitable timer, NULL before Windows 10 1803.
+	HANDLE timer;
+};
+
+/// The scheduler of the main loop.
+static struct frame_scheduler s_scheduler;
+
+/// Get the current performance counter value.
+///
+/// @return Counter value.
+static long long query_counter(void)
+{
+	LARGE_INTEGER counter;
+	const BOOL result = QueryPerformanceCounter(&counter);
+	assert(result);
+	UNREFERENCED_PARAMETER(result);
+	return counter.QuadPart;
+}
+
+/// Get the counter value when an event of a fixed rate is due.
+///
+/// Computed from the event index instead of adding up intervals, so
+/// rounding never makes the rate drift.
+///
+/// @param[in] index Index of the event.
+/// @param[in] rate Events per second.
+/// @return Counter value of the deadline.
+static long long rate_deadline(long long index, int rate)
+{
+	const long long frequency = s_scheduler.frequency;
+	return s_scheduler.start + index / rate * frequency +
+		index % rate * frequency / rate;
+}
+
+/// Get the counter value when a tick is due.
+///
+/// @param[in] tick Index of the tick.
+/// @return Counter value of the deadline.
+static long long tick_deadline(long long tick)
+{
+	return rate_deadline(tick, k_tickrate);
+}
+
+/// Check whether frames are presented on a timer of their own.
+///
+/// @return False if a frame is presented after every tick.
+static bool has_present_timer(void)
+{
+	return s_scheduler.present_rate > 0
+		&& s_scheduler.present_rate < k_tickrate;
+}
+
+/// Initialize the scheduler and raise the system timer resolution.
+///
+/// @param[in] present_rate Frames presented per second, 0 for every tick.
+/// @param[in] fast_forward Run ticks as fast as possible.
+static void scheduler_init(int present_rate, bool fast_forward)
+{
+	LARGE_INTEGER frequency;
+	const BOOL result = QueryPerformanceFrequency(&frequency);
+	assert(result);
+	UNREFERENCED_PARAMETER(result);
+
+	const MMRESULT mm_result = timeBeginPeriod(1);
+	assert(mm_result == TIMERR_NOERROR);
+	UNREFERENCED_PARAMETER(mm_result);
+
+	memset(&s_scheduler, 0, sizeof(s_scheduler));
+	s_scheduler.frequency = frequency.QuadPart;
+	s_scheduler.start = query_counter();
+	s_scheduler.present_rate = present_rate;
+	s_scheduler.fast_forward = fast_forward;
+	s_scheduler.timer = CreateWaitableTimerExW(NULL, NULL,
+		CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+}
+
+/// Restore the timer resolution and report the tick rate and the
+/// measured jitter.
+static void scheduler_end(void)
+{
+	timeEndPeriod(1);
+	if (s_scheduler.timer)
+		CloseHandle(s_scheduler.timer);
+
+	const long long elapsed = query_counter() - s_scheduler.start;
+	char report[256];
+	sprintf_s(report, sizeof(report),
+		"nAtomix: %lld ticks in %.3f s (%.1f ticks/s)\n",
+		s_scheduler.ticks,
+		(double)elapsed / s_scheduler.frequency,
+		elapsed ? (double)s_scheduler.ticks * s_scheduler.frequency / elapsed
+			: 0.0);
+	OutputDebugStringA(report);
+
+	if (!s_scheduler.jitter_count)
+		return;
+
+	const double to_us = 1000000.0 / s_scheduler.frequency;
+	sprintf_s(report, sizeof(report),
+		"nAtomix: jitter mean %.1f us, max %.1f us, %lld dropped\n",
+		s_scheduler.jitter_sum * to_us / s_scheduler.jitter_count,
+		s_scheduler.jitter_max * to_us,
+		s_scheduler.dropped);
+	OutputDebugStringA(report);
+}
+
+/// Check whether the next tick is due, and account for it if so.
+///
+/// @return True if the caller should run a tick now.
+static bool scheduler_tick_due(void)
+{
+	// Return to the message loop every now and then
+	if (s_scheduler.fast_forward)
+	{
+		if (s_scheduler.batch == k_fast_forward_batch)
+		{
+			s_scheduler.batch = 0;
+			return false;
+		}
+
+		++s_scheduler.batch;
+		++s_scheduler.ticks;
+		return true;
+	}
+
+	const long long now = query_counter();
+	const long long deadline = tick_deadline(s_scheduler.ticks);
+	if (now < deadline)
+		return false;
+
+	// Too far behind, e.g. the window was dragged. Skip ahead instead of
+	// running a burst of ticks.
+	if (now - deadline > k_max_catch_up_ticks * s_scheduler.frequency /
+		k_tickrate)
+	{
+		const long long behind = (now - s_scheduler.start) * k_tickrate /
+			s_scheduler.frequency;
+		s_scheduler.dropped += behind - s_scheduler.ticks;
+		s_scheduler.ticks = behind;
+	}
+	else
+	{
+		const long long late = now - deadline;
+		s_scheduler.jitter_sum += late;
+		s_scheduler.jitter_max = MAX(s_scheduler.jitter_max, late);
+		++s_scheduler.jitter_count;
+	}
+
+	++s_scheduler.ticks;
+	return true;
+}
+
+/// Check whether a frame should be presented, and account for it if so.
+///
+/// @return True if the caller should render and present a frame now.
+static bool scheduler_present_due(void)
+{
+	if (!has_present_timer())
+	{
+		const bool due = s_scheduler.presented_ticks != s_scheduler.ticks;
+		s_scheduler.presented_ticks = s_scheduler.ticks;
+		return due;
+	}
+
+	const long long now = query_counter();
+	if (now < rate_deadline(s_scheduler.presents, s_scheduler.present_rate))
+		return false;
+
+	// Never present a burst of frames after falling behind
+	s_scheduler.presents = (now - s_scheduler.start) *
+		s_scheduler.present_rate / s_scheduler.frequency + 1;
+	return true;
+}
+
+/// Get how far we are between the last tick and the next one.
+///
+/// @return Fraction of a tick out of k_tick_fraction_one.
+static int scheduler_tick_fraction(void)
+{
+	if (!has_present_timer() || !s_scheduler.ticks || s_scheduler.fast_forward)
+		return k_tick_fraction_one;
+
+	const long long last = tick_deadline(s_scheduler.ticks - 1);
+	const long long next = tick_deadline(s_scheduler.ticks);
+	const long long fraction = (query_counter() - last) *
+		k_tick_fraction_one / (next - last);
+	return (int)CLAMP(fraction, 0, k_tick_fraction_one);
+}
+
+/// Wait until the next tick or frame is due.
+///
+/// Sleeps on the high resolution timer until k_spin_microseconds are
+/// left, or without one in 1 ms steps until under a millisecond is left,
+/// then spins for the rest so we wake up on time without burning a core.
+static void scheduler_wait(void)
+{
+	if (s_scheduler.fast_forward)
+		return;
+
+	long long deadline = tick_deadline(s_scheduler.ticks);
+	if (has_present_timer())
+		deadline = MIN(deadline, rate_deadline(s_scheduler.presents,
+			s_scheduler.present_rate));
+	const long long frequency = s_scheduler.frequency;
+	const long long spin = k_spin_microseconds * frequency / 1000000;
+	const long long remaining = deadline - query_counter();
+
+	if (s_scheduler.timer && remaining > spin)
+	{
+		// Relative due times are negative, in 100 ns units
+		LARGE_INTEGER due;
+		due.QuadPart = -((remaining - spin) * 10000000 / frequency);
+		if (SetWaitableTimer(s_scheduler.timer, &due, 0, NULL, NULL, FALSE))
+			WaitForSingleObject(s_scheduler.timer, INFINITE);
+	}
+	else
+	{
+		// Sleep(1) may oversleep a little, only the timer is exact
+		while (deadline - query_counter() > frequency / 1000)
+			Sleep(1);
+	}
+
+	while (query_counter() < deadline)
+		YieldProcessor();
+}
+
 /// Get the actual rendered window width.
-inline int get_window_width(void)
+static inline int get_window_width(void)
 {
 	return s_display_size_multiplier * k_pixel_width;
 }
 
 /// Get the actual rendered window height.
-inline int get_window_height(void)
+static inline int get_window_height(void)
 {
 	return s_display_size_multiplier * k_pixel_height;
 }
 
+/// Print a line of the telemetry report to the debugger.
+///
+/// @param[in] line The line.
+static void print_debug_line(const char* line)
+{
+	OutputDebugStringA(line);
+}
+
+/// Get the value of a command line option.
+///
+/// @param[in] cmd_line The command line.
+/// @param[in] name Name of the option, like L"--play".
+/// @param[out] value Value of the option, up to the next space.
+/// @param[in] size Size of \p value in bytes.
+/// @return True if the option was found.
+static bool get_cmd_option(LPCWSTR cmd_line, LPCWSTR name, char* value,
+	size_t size)
+{
+	const wchar_t* option = wcsstr(cmd_line, name);
+	if (!option)
+		return false;
+
+	option += wcslen(name);
+	while (*option == L' ')
+		++option;
+
+	wchar_t wide[MAX_PATH];
+	size_t len = 0;
+	while (option[len] && option[len] != L' ' && len < MAX_PATH - 1)
+	{
+		wide[len] = option[len];
+		++len;
+	}
+	wide[len] = 0;
+
+	size_t converted;
+	return wcstombs_s(&converted, value, size, wide, _TRUNCATE) == 0;
+}
+
 // Forward declarations
 static ATOM register_class(HINSTANCE instance);
 static BOOL init_instance(HINSTANCE, int);
@@ -108,7 +440,12 @@ int APIENTRY wWinMain(HINSTANCE instance,
 	int cmd_show)
 {
 	UNREFERENCED_PARAMETER(prev_instance);
-	UNREFERENCED_PARAMETER(cmd_line);
+
+	// --fps N overrides the presentation rate
+	int present_rate = k_present_rate;
+	const wchar_t* fps = wcsstr(cmd_line, L"--fps");
+	if (fps)
+		present_rate = _wtoi(fps + wcslen(L"--fps"));
 
 	// Initialize global strings
 	register_class(instance);
@@ -120,33 +457,34 @@ int APIENTRY wWinMain(HINSTANCE instance,
 		return FALSE;
 
 
-	// Lets figure out QueryPerformanceCounter resolution
-	long long one_millisecond;
+	// --trace FILE writes a trace event JSON of the run
+	char path[MAX_PATH];
+	if (get_cmd_option(cmd_line, L"--trace", path, sizeof(path))
+		&& trace_start(path))
+		trace_name_thread("game");
+
+	on_game_start();
+
+	// --play FILE replays recorded input, --record FILE records it
+	if (get_cmd_option(cmd_line, L"--play", path, sizeof(path)))
 	{
-		LARGE_INTEGER first;
-		result = QueryPerformanceCounter(&first);
-		assert(result);
-		Sleep(160);
-		LARGE_INTEGER second;
-		result = QueryPerformanceCounter(&second);
-		assert(result);
-		one_millisecond = (second.QuadPart - first.QuadPart) / 160;
+		time_t epoch;
+		if (input_play_start(path, &epoch))
+			on_game_set_epoch(epoch);
 	}
+	if (get_cmd_option(cmd_line, L"--record", path, sizeof(path)))
+		input_record_start(path, on_game_get_epoch());
 
-	on_game_start();
+	// --fast-forward runs ticks as fast as possible
+	const bool fast_forward = wcsstr(cmd_line, L"--fast-forward") != NULL;
+
+	scheduler_init(present_rate, fast_forward);
 
+	// Like the headless build, playing stops when the recording ends
 	MSG msg;
 	msg.wParam = 0;
-	while (g_running)
+	while (g_running && !input_play_finished())
 	{
-		LARGE_INTEGER frame_begin_time;
-		result = QueryPerformanceCounter(&frame_begin_time);
-		assert(result);
-
-		// Clear the fresh state change flags from the keys
-		for (int i = 0; i < 0x100; ++i)
-			g_key_states[i] &= KeyFlag_PushState;
-
 		// Main message loop:
 		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
@@ -157,30 +495,38 @@ int APIENTRY wWinMain(HINSTANCE instance,
 		if (!s_is_running)
 			break;
 
-		on_game_tick();
+		while (g_running && !input_play_finished() && scheduler_tick_due())
+			on_game_tick();
 
-		// For whatever reason MS uses BGRA
-		for(int i = 0; i < 320 * 240; ++i)
+		// Present the last frame the render thread finished, if it changed
+		const struct color* frame = on_game_acquire_frame(false);
+		if (frame)
 		{
-			struct color rgba = g_bitmap[i];
-			struct color bgra = color_rgba(rgba.b, rgba.g, rgba.r, rgba.a);
-			g_bitmap[i] = bgra;
-		}
+			const long long present_start = telemetry_now();
 
-		result = RedrawWindow(s_hwnd, NULL, NULL, RDW_FRAME | RDW_INVALIDATE);
-		assert(result);
+			// Paint right away, while the frame is held
+			s_present_frame = frame;
+			result = RedrawWindow(s_hwnd, NULL, NULL,
+				RDW_FRAME | RDW_INVALIDATE | RDW_UPDATENOW);
+			assert(result);
+			s_present_frame = NULL;
+			on_game_release_frame();
 
-		// Lets burn some cpu
-		{
-			LARGE_INTEGER current_time;
-			do
-				QueryPerformanceCounter(&current_time);
-			while (current_time.QuadPart < frame_begin_time.QuadPart +
-				one_millisecond * 1000 / k_tickrate);
+			telemetry_record(TelemetryStage_Present,
+				telemetry_now() - present_start);
 		}
+
+		if (scheduler_present_due())
+			on_game_render(scheduler_tick_fraction());
+
+		scheduler_wait();
 	}
 
+	scheduler_end();
+	input_record_stop();
 	on_game_end();
+	trace_stop();
+	telemetry_report(&print_debug_line);
 
 	return (int)msg.wParam;
 }
@@ -244,21 +590,30 @@ static BOOL init_instance(HINSTANCE instance, int cmd_show)
 	return TRUE;
 }
 
-/// Handles drawing the global bitmap onto the window HDC.
+/// Handles drawing the rendered frame onto the window HDC.
 ///
-/// Called on every window update. Creates a windows bitmap, renders
-/// the global bitmap onto it, then copies it over to the window's
-/// HDC
+/// Called on every window update. Creates a windows bitmap from the
+/// frame being presented, or the last rendered one if the window was
+/// just uncovered, then copies it over to the window's HDC.
 ///
 /// @param[in] hdc HDC to draw onto
 static void WINAPI custom_drawer(HDC hdc)
 {
+	const struct color* frame = s_present_frame;
+	const bool acquired = !frame;
+	if (acquired)
+		frame = on_game_acquire_frame(true);
+	if (!frame)
+		return;
+
 	const HDC mem_hdc = CreateCompatibleDC(NULL);
 	assert(mem_hdc);
 	//const HBITMAP bmp = CreateCompatibleBitmap(hdc, width, height);
 	const HBITMAP bmp = CreateBitmap(
-		k_pixel_width, k_pixel_height, 1, 32, g_bitmap);
+		k_pixel_width, k_pixel_height, 1, 32, frame);
 	assert(bmp);
+	if (acquired)
+		on_game_release_frame();
 
 	SelectObject(mem_hdc, bmp);
 
@@ -273,18 +628,6 @@ static void WINAPI custom_drawer(HDC hdc)
 	assert(result);
 }
 
-/// Processes key state changes.
-///
-/// Sets changed state unconditionally, and down state if the key
-/// was pressed.
-///
-/// @param[in] key Key to change state of.
-/// @param[in] pressed Whether it was pressed or released.
-void process_key_state_change(int key, bool pressed)
-{
-	g_key_states[key & 0xFF] = pressed | KeyFlag_ChangedState;
-}
-
 /// Figures out what keys got pressed from the window event.
 ///
 /// @param[in] message The received message code.
@@ -301,31 +644,31 @@ void update_key_states(UINT message, WPARAM w_param, LPARAM l_param)
 	case WM_SYSKEYDOWN:
 	case WM_SYSKEYUP:
 		down = !((l_param >> 31) & 1);
-		process_key_state_change((int)w_param, down);
+		input_key_event((int)w_param, down);
 		break;
 
 	case WM_LBUTTONDOWN:
 		down = true;
 	case WM_LBUTTONUP:
-		process_key_state_change(Key_LeftButton, down);
+		input_key_event(Key_LeftButton, down);
 		break;
 
 	case WM_RBUTTONDOWN:
 		down = true;
 	case WM_RBUTTONUP:
-		process_key_state_change(Key_RightButton, down);
+		input_key_event(Key_RightButton, down);
 		break;
 
 	case WM_MBUTTONDOWN:
 		down = true;
 	case WM_MBUTTONUP:
-		process_key_state_change(Key_MiddleButton, down);
+		input_key_event(Key_MiddleButton, down);
 		break;
 
 	case WM_XBUTTONDOWN:
 		down = true;
 	case WM_XBUTTONUP:
-		process_key_state_change(
+		input_key_event(
 			GET_XBUTTON_WPARAM(w_param) == 1
 				? Key_ExtraButton1
 				: Key_ExtraButton2, down);
@@ -351,6 +694,10 @@ static LRESULT CALLBACK window_process(HWND hwnd,
 {
 	update_key_states(message, w_param, l_param);
 
+	// F11 prints the stage timings to the debugger
+	if (message == WM_KEYDOWN && w_param == Key_F11)
+		telemetry_report(&print_debug_line);
+
 	switch (message)
 	{
 	case WM_PAINT: